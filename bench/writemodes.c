@@ -0,0 +1,156 @@
+/**
+ * writemodes.c
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief benchmark of the GLBWriteModes
+ *
+ * Each frame writes a stream vertex buffer that the previous frame's draw still
+ * reads, then draws it, so that a synchronized write has to wait for the GPU.
+ * Every mode is run writing the whole buffer and writing 1/64 of it. The time
+ * spent in glbWriteBufferMode is reported separately from the frame time, since
+ * it holds any stall the mode causes.
+ *
+ * Runs headless through an EGL surfaceless context. Build with 'make bench',
+ * then run 'LD_LIBRARY_PATH=. bench/writemodes [frames] [vertices]'.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "glb.h"
+
+static const char *vertexsource =
+    "#version 130\n"
+    "in vec2 position;\n"
+    "void main() { gl_Position = vec4(position, 0.0, 1.0); }\n";
+
+static const char *fragmentsource =
+    "#version 130\n"
+    "out vec4 color;\n"
+    "void main() { color = vec4(1.0); }\n";
+
+static const char *modenames[] = {"synchronized", "orphan", "invalidate", "unsynchronized"};
+
+static double benchNow(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+static int benchContext(void)
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay display = getPlatformDisplay ?
+        getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) :
+        eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(!eglInitialize(display, NULL, NULL)) return 1;
+
+    eglBindAPI(EGL_OPENGL_API);
+    EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if(!context) return 1;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    printf("%s, %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int errcode;
+    int frames = argc > 1 ? atoi(argv[1]) : 300;
+    size_t nverts = argc > 2 ? (size_t) atol(argv[2]) : 3 * 8192;
+    nverts -= nverts % (3 * 64);
+    if(frames <= 0 || !nverts)
+    {
+        fprintf(stderr, "usage: %s [frames] [vertices, at least 192]\n", argv[0]);
+        return 1;
+    }
+
+    if(benchContext())
+    {
+        fprintf(stderr, "could not create an OpenGL context\n");
+        return 1;
+    }
+
+    GLBProgram *program = glbCreateProgram(&errcode);
+    glbProgramAttachNewShaderSource(program, -1, vertexsource, GLB_VERTEX_SHADER);
+    glbProgramAttachNewShaderSource(program, -1, fragmentsource, GLB_FRAGMENT_SHADER);
+    GLBTexture *target = glbCreateTexture(0, GLB_RGBA, 16, 16, 1, NULL, &errcode);
+    GLBFramebuffer *framebuffer = glbCreateFramebuffer(&errcode);
+    glbFramebufferColor(framebuffer, 0, target);
+    glbProgramOutput(program, framebuffer);
+    glViewport(0, 0, 16, 16);
+
+    // tiny triangles, so the frame time is spent on vertices and not on pixels
+    size_t i;
+    float *vertices = malloc(nverts * 2 * sizeof(float));
+    if(!vertices) return 1;
+    for(i = 0; i < nverts; i++)
+    {
+        vertices[2 * i] = (i % 3 == 1) ? -0.99f : -1.0f;
+        vertices[2 * i + 1] = (i % 3 == 2) ? -0.99f : -1.0f;
+    }
+
+    GLBVertexLayout layout[] = {{2, GLB_FLOAT, 0, 2 * sizeof(float), 0}};
+    size_t bytes = nverts * 2 * sizeof(float);
+    size_t part = bytes / 64;
+
+    printf("%zu byte buffer, %d frames, ms per frame\n", bytes, frames);
+    printf("%-16s %-8s %10s %10s\n", "mode", "written", "write", "frame");
+
+    int whole, mode, f;
+    for(whole = 1; whole >= 0; whole--)
+    {
+        for(mode = GLB_WRITE_SYNCHRONIZED; mode <= GLB_WRITE_UNSYNCHRONIZED; mode++)
+        {
+            GLBBuffer *buffer = glbCreateVertexBuffer(nverts, 2 * sizeof(float), vertices,
+                                                      1, layout, GLB_STREAM_DRAW, &errcode);
+            if(!buffer) return 1;
+            glFinish();
+
+            double writing = 0;
+            double start = benchNow();
+            for(f = 0; f < frames; f++)
+            {
+                vertices[0] = -1.0f + (f & 1) * 1e-3f;
+                double t = benchNow();
+                if(whole)
+                {
+                    glbWriteBufferMode(buffer, 0, bytes, vertices, mode);
+                } else
+                {
+                    glbWriteBufferMode(buffer, (f % 64) * part, part, vertices, mode);
+                }
+                writing += benchNow() - t;
+                glbProgramDraw(program, buffer);
+            }
+            glFinish();
+            double total = benchNow() - start;
+
+            printf("%-16s %-8s %10.3f %10.3f\n", modenames[mode], whole ? "whole" : "1/64",
+                   writing / frames, total / frames);
+            glbReleaseBuffer(buffer);
+        }
+    }
+
+    free(vertices);
+    glbReleaseFramebuffer(framebuffer);
+    glbReleaseTexture(target);
+    glbReleaseProgram(program);
+    return 0;
+}
@@ -14,6 +14,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // sz is the size for each element (sz/nmemb)
 static int guessType(size_t sz)
 {
@@ -30,26 +34,71 @@ static int guessType(size_t sz)
     }
 }
 
-GLBBuffer* glbCreateBuffer (size_t nmemb, size_t sz, const void *const ptr, int usage, int *errcode_ret)
+/**
+ * @private
+ * allocates a buffer object without a GL buffer, for the caller to set globj.
+ */
+GLBBuffer *glbAllocBuffer(size_t nmemb, size_t sz)
 {
-    int errcode;
-
-    GLB_ASSERT(nmemb * sz, GLB_INVALID_ARGUMENT, ERROR_BUFFER);
-
     GLBBuffer *buffer = malloc(sizeof(GLBBuffer));
-    GLB_ASSERT(buffer, GLB_OUT_OF_MEMORY, ERROR_BUFFER);
+    if(!buffer) return NULL;
+
+    buffer->globj = 0;
+    buffer->offset = 0;
+    buffer->capacity = nmemb * sz;
+    buffer->heap = NULL;
+    buffer->block = NULL;
+    buffer->pool = NULL;
+    buffer->poolnext = NULL;
+    buffer->usage = 0;
+    buffer->fence = NULL;
+    buffer->vdata.layout = NULL;
+    buffer->remap = NULL;
+    buffer->clusters = NULL;
+    buffer->nvertexarrays = 0;
+    glbBufferReset(buffer, nmemb, sz);
+    return buffer;
+}
+
+/**
+ * @private
+ * resets everything about a buffer but its storage, as if newly created with
+ * 'nmemb' members of 'sz' bytes. The buffer must hold no layout, remap table,
+ * clusters or vertex arrays.
+ */
+void glbBufferReset(GLBBuffer *buffer, size_t nmemb, size_t sz)
+{
     buffer->refcount = 1;
-    glGenBuffers(1, &buffer->globj);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer->globj);
-    glBufferData(GL_ARRAY_BUFFER, nmemb * sz, ptr, usage);
-    //TODO: detect errors
+    buffer->serial = glbGenSerial();
+    buffer->writemode = GLB_WRITE_SYNCHRONIZED;
+    buffer->fencewrites = false;
+    glbReleaseFence(buffer->fence);
+    buffer->fence = NULL;
 
     buffer->nmemb = nmemb;
     buffer->sz = sz;
     buffer->vdata.count = 0;
     buffer->vdata.layout = NULL;
-    buffer->idata.type = guessType(sz / nmemb); // guess index buffer info
+    buffer->idata.type = guessType(sz); // guess index buffer info
     buffer->idata.count = nmemb; // guess index buffer info
+    buffer->idata.offset = 0;
+    buffer->nremap = 0;
+    buffer->nextvertexarray = 0;
+}
+
+GLBBuffer* glbCreateBuffer (size_t nmemb, size_t sz, const void *const ptr, int usage, int *errcode_ret)
+{
+    int errcode;
+
+    GLB_ASSERT(nmemb * sz, GLB_INVALID_ARGUMENT, ERROR_BUFFER);
+
+    GLBBuffer *buffer = glbAllocBuffer(nmemb, sz);
+    GLB_ASSERT(buffer, GLB_OUT_OF_MEMORY, ERROR_BUFFER);
+    glGenBuffers(1, &buffer->globj);
+    glbStateBindBuffer(GL_ARRAY_BUFFER, buffer->globj);
+    buffer->usage = usage & GLB_BUFFER_USAGE_MASK;
+    glBufferData(GL_ARRAY_BUFFER, nmemb * sz, ptr, buffer->usage);
+    //TODO: detect errors
 
     GLB_SET_ERROR(GLB_SUCCESS);
     return buffer;
@@ -64,10 +113,93 @@ ERROR_BUFFER:
     return NULL;
 }
 
-GLBBuffer* glbCreateIndexBuffer  (size_t nmemb, size_t sz, const void *const ptr, int type,
+/**
+ * @private
+ * creates a buffer of 'size' bytes with immutable storage, as glBufferStorage.
+ * @param flags the glBufferStorage flags, such as GL_MAP_PERSISTENT_BIT
+ */
+GLBBuffer *glbCreateBufferStorage(size_t size, GLbitfield flags, int *errcode_ret)
+{
+    int errcode;
+    GLB_ASSERT(size, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(glbCanUseFeature(GLB_BUFFER_STORAGE_FEATURE), GLB_GL_TOO_OLD, ERROR);
+
+    GLBBuffer *buffer = glbAllocBuffer(size, 1);
+    GLB_ASSERT(buffer, GLB_OUT_OF_MEMORY, ERROR);
+    glGenBuffers(1, &buffer->globj);
+    glbStateBindBuffer(GL_ARRAY_BUFFER, buffer->globj);
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return buffer;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+/**
+ * bitwise or of 'n' 32 bit indices. Every index fits in 16 bits if the result does,
+ * which is cheaper to find than the maximum without unsigned 32 bit compares.
+ */
+static uint32_t glbIndexBits(const uint32_t *indices, size_t n)
+{
+    size_t i = 0;
+    uint32_t bits = 0;
+
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    for(; i + 4 <= n; i += 4)
+    {
+        acc = _mm_or_si128(acc, _mm_loadu_si128((const __m128i*) &indices[i]));
+    }
+    acc = _mm_or_si128(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_or_si128(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    bits = (uint32_t) _mm_cvtsi128_si32(acc);
+#endif
+
+    for(; i < n; i++)
+    {
+        bits |= indices[i];
+    }
+    return bits;
+}
+
+/**
+ * creates a buffer holding vertex indices of the given type.
+ * @param usage a GLBBufferUsage. If GLB_NARROW_INDICES is or'd in, 32 bit
+ * indices are stored as 16 bit indices when all of them fit, and the buffer's
+ * index type is set to match.
+ */
+GLBBuffer* glbCreateIndexBuffer  (size_t nmemb, size_t sz, const void * const ptr, int type,
                                   int usage, int *errcode_ret)
 {
-    GLBBuffer *buf = glbCreateBuffer(nmemb, sz, ptr, usage, errcode_ret);
+    uint16_t *narrow = NULL;
+
+    if((usage & GLB_NARROW_INDICES) && ptr && glbTypeSizeof(type) == sizeof(uint32_t))
+    {
+        size_t n = (nmemb * sz) / sizeof(uint32_t);
+        const uint32_t *indices = ptr;
+        if(n && glbIndexBits(indices, n) <= UINT16_MAX)
+        {
+            narrow = malloc(n * sizeof(uint16_t));
+        }
+
+        if(narrow)
+        {
+            size_t i;
+            for(i = 0; i < n; i++)
+            {
+                narrow[i] = (uint16_t) indices[i];
+            }
+            nmemb = n;
+            sz = sizeof(uint16_t);
+            type = GLB_USHORT;
+        }
+    }
+
+    GLBBuffer *buf = glbCreateBuffer(nmemb, sz, narrow ? narrow : ptr, usage, errcode_ret);
+    free(narrow);
 
     if(!buf)
     {
@@ -79,27 +211,128 @@ GLBBuffer* glbCreateIndexBuffer  (size_t nmemb, size_t sz, const void *const ptr
     return buf;
 }
 
+/**
+ * creates a buffer holding vertices described by 'desc'.
+ * @param usage a GLBBufferUsage. If GLB_WELD_VERTICES is or'd in, vertices whose
+ * attributes are bit-identical are stored once, and the buffer keeps a remap
+ * table from the vertices passed in to the ones stored. Index buffers written
+ * against 'ptr' must then be rewritten with glbRemapIndexBuffer.
+ */
 GLBBuffer* glbCreateVertexBuffer (size_t nmemb, size_t sz, const void *const ptr,
                                   int ndesc, GLBVertexLayout *desc,
                                   int usage, int *errcode_ret)
 {
-    GLBBuffer *buf = glbCreateBuffer(nmemb, sz, ptr, usage, errcode_ret);
+    int errcode;
+    void *welded = NULL;
+    unsigned int *remap = NULL;
+    size_t nremap = nmemb;
+
+    if((usage & GLB_WELD_VERTICES) && ptr && nmemb)
+    {
+        welded = malloc(nmemb * sz);
+        remap = malloc(nmemb * sizeof(unsigned int));
+        GLB_ASSERT(welded && remap, GLB_OUT_OF_MEMORY, ERROR);
+        memcpy(welded, ptr, nmemb * sz);
+
+        errcode = glbWeldVertices(welded, sz, nmemb, ndesc, desc, remap, &nmemb);
+        GLB_ASSERT(!errcode, errcode, ERROR);
+    }
+
+    GLBBuffer *buf = glbCreateBuffer(nmemb, sz, welded ? welded : ptr, usage, errcode_ret);
+    free(welded);
 
     if(!buf)
     {
+        free(remap);
         return NULL;
     }
 
+    buf->remap = remap;
+    buf->nremap = remap ? nremap : 0;
     glbVertexBufferFormat(buf, ndesc, desc);
 
     return buf;
+
+ERROR:
+    free(welded);
+    free(remap);
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+/**
+ * creates a vertex buffer from float vertex data, storing attributes at a lower
+ * precision. The buffer's layout describes the quantized vertices, so it can be
+ * drawn with the same program; see glbQuantizeVertices.
+ * @param ptr vertices described by 'desc'
+ * @param precision a GLBVertexPrecision for each attribute in 'desc'
+ * @param usage as for glbCreateVertexBuffer. GLB_WELD_VERTICES welds the quantized
+ * vertices, which merges vertices that only differed below the new precision.
+ */
+GLBBuffer* glbCreateQuantizedVertexBuffer (size_t nmemb, const void *const ptr,
+                                           int ndesc, GLBVertexLayout *desc,
+                                           const int *precision,
+                                           int usage, int *errcode_ret)
+{
+    int errcode;
+    size_t sz;
+    void *data = NULL;
+    GLBVertexLayout *qdesc = NULL;
+    GLB_ASSERT(nmemb && ptr && ndesc > 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    qdesc = malloc(sizeof(GLBVertexLayout) * ndesc);
+    GLB_ASSERT(qdesc, GLB_OUT_OF_MEMORY, ERROR);
+    errcode = glbQuantizeVertices(ptr, nmemb, ndesc, desc, precision, NULL, qdesc, &sz);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    data = malloc(nmemb * sz);
+    GLB_ASSERT(data, GLB_OUT_OF_MEMORY, ERROR);
+    errcode = glbQuantizeVertices(ptr, nmemb, ndesc, desc, precision, data, qdesc, &sz);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    GLBBuffer *buf = glbCreateVertexBuffer(nmemb, sz, data, ndesc, qdesc, usage, errcode_ret);
+    free(data);
+    free(qdesc);
+    return buf;
+
+ERROR:
+    free(data);
+    free(qdesc);
+    GLB_SET_ERROR(errcode);
+    return NULL;
 }
 
 void glbDeleteBuffer (GLBBuffer *buffer)
 {
     if(!buffer) return;
+    glbBufferClearVertexArrays(buffer);
     free(buffer->vdata.layout);
-    glDeleteBuffers(1, &buffer->globj);
+    buffer->vdata.layout = NULL;
+    buffer->vdata.count = 0;
+    free(buffer->remap);
+    buffer->remap = NULL;
+    glbDeleteClusters(buffer->clusters);
+    buffer->clusters = NULL;
+
+    // pooled buffers keep their storage, and the object, for reuse
+    if(buffer->pool)
+    {
+        glbBufferPoolReturn(buffer->pool, buffer);
+        return;
+    }
+
+    glbReleaseFence(buffer->fence);
+    if(buffer->heap)
+    {
+        // views only give their range back, the heap owns the GL buffer
+        glbBufferHeapFree(buffer->heap, buffer->block);
+        glbReleaseBufferHeap(buffer->heap);
+    } else
+    {
+        glbStateDeleteBuffer(buffer->globj);
+        glDeleteBuffers(1, &buffer->globj);
+    }
+    free(buffer);
 }
 
 void glbRetainBuffer (GLBBuffer *buffer)
@@ -118,44 +351,229 @@ void glbReleaseBuffer(GLBBuffer *buffer)
     }
 }
 
+/**
+ * fences a write to the buffer, if its writes are fenced.
+ */
+static void glbBufferFenceWrite(GLBBuffer *buffer)
+{
+    if(buffer->fencewrites)
+    {
+        glbFenceReplace(&buffer->fence);
+    }
+}
+
+/**
+ * writes 'sz' bytes to the buffer at 'offset', in the mode set with the
+ * GLB_WRITE_MODE option. Buffers are written synchronized unless set otherwise.
+ */
 int glbWriteBuffer (GLBBuffer *buffer, size_t offset, size_t sz, void *ptr)
 {
     if(!buffer) return 0;
-    glBufferSubData(buffer->globj, offset, sz, ptr);
-    return 0;
+    return glbWriteBufferMode(buffer, offset, sz, ptr, buffer->writemode);
+}
+
+/**
+ * copies 'sz' bytes through a mapping of the range, with 'flags' added to
+ * GL_MAP_WRITE_BIT.
+ */
+static int glbWriteBufferMapped(GLBBuffer *buffer, size_t offset, size_t sz,
+                                const void *ptr, GLbitfield flags)
+{
+    void *mapped = glbMapBufferRange(buffer, offset, sz, GLB_MAP_WRITE_BIT | flags);
+    if(!mapped) return GLB_MAP_ERROR;
+    memcpy(mapped, ptr, sz);
+    return glUnmapBuffer(GL_COPY_WRITE_BUFFER) ? GLB_SUCCESS : GLB_WRITE_ERROR;
+}
+
+/**
+ * writes 'sz' bytes to the buffer at 'offset'. A synchronized write stalls until
+ * the GPU is done with the buffer if a submitted draw still reads it; the other
+ * modes avoid the stall:
+ *
+ *  - GLB_WRITE_ORPHAN gives the buffer new storage when the whole buffer is
+ *    written, leaving the old storage to the draws still reading it. Heap views
+ *    and immutable buffers can not be re-specified, and partial writes would
+ *    lose the rest of the buffer; these are written as GLB_WRITE_INVALIDATE.
+ *  - GLB_WRITE_INVALIDATE discards the range before writing it, so the driver
+ *    may write into fresh memory rather than wait.
+ *  - GLB_WRITE_UNSYNCHRONIZED writes through an unsynchronized mapping. The
+ *    caller must know the GPU is not reading the range, eg. through a fence.
+ *
+ * Modes that need a newer GL than the current one fall back to a synchronized
+ * write.
+ * @param mode one of enum GLBWriteModes
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if the range is outside the buffer,
+ * or GLB_MAP_ERROR/GLB_WRITE_ERROR if a mapped write failed.
+ */
+int glbWriteBufferMode (GLBBuffer *buffer, size_t offset, size_t sz,
+                        const void *ptr, int mode)
+{
+    int errcode;
+    GLB_ASSERT(buffer && ptr, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(offset + sz <= buffer->nmemb * buffer->sz && offset + sz >= offset,
+               GLB_INVALID_ARGUMENT, ERROR);
+    if(!sz) return GLB_SUCCESS;
+
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, buffer->globj);
+    errcode = GLB_SUCCESS;
+    switch(mode)
+    {
+        case GLB_WRITE_ORPHAN:
+            if(buffer->usage && offset == 0 && sz == buffer->nmemb * buffer->sz)
+            {
+                if(sz == buffer->capacity)
+                {
+                    glBufferData(GL_COPY_WRITE_BUFFER, sz, ptr, buffer->usage);
+                } else
+                {
+                    // pooled buffers keep their size class
+                    glBufferData(GL_COPY_WRITE_BUFFER, buffer->capacity, NULL, buffer->usage);
+                    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sz, ptr);
+                }
+                break;
+            }
+            // fall through, only a whole buffer can be orphaned
+        case GLB_WRITE_INVALIDATE:
+            if(glbCanUseFeature(GLB_INVALIDATE_SUBDATA_FEATURE))
+            {
+                glInvalidateBufferSubData(buffer->globj, buffer->offset + offset, sz);
+                glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->offset + offset, sz, ptr);
+            } else if(glbCanUseFeature(GLB_MAP_BUFFER_RANGE_FEATURE))
+            {
+                errcode = glbWriteBufferMapped(buffer, offset, sz, ptr,
+                                               GL_MAP_INVALIDATE_RANGE_BIT);
+            } else
+            {
+                glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->offset + offset, sz, ptr);
+            }
+            break;
+        case GLB_WRITE_UNSYNCHRONIZED:
+            if(glbCanUseFeature(GLB_MAP_BUFFER_RANGE_FEATURE))
+            {
+                errcode = glbWriteBufferMapped(buffer, offset, sz, ptr,
+                                               GL_MAP_INVALIDATE_RANGE_BIT |
+                                               GL_MAP_UNSYNCHRONIZED_BIT);
+                break;
+            }
+            // fall through
+        case GLB_WRITE_SYNCHRONIZED:
+            glBufferSubData(GL_COPY_WRITE_BUFFER, buffer->offset + offset, sz, ptr);
+            break;
+        default:
+            GLB_ASSERT(0, GLB_INVALID_ARGUMENT, ERROR);
+    }
+
+    GLB_ASSERT(!errcode, errcode, ERROR);
+    glbBufferFenceWrite(buffer);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
 }
 
 int glbReadBuffer (GLBBuffer *buffer, size_t offset, size_t sz, void *ptr)
 {
     if(!buffer) return 0;
-    glGetBufferSubData(buffer->globj, offset, sz, ptr);
+    glbStateBindBuffer(GL_COPY_READ_BUFFER, buffer->globj);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, buffer->offset + offset, sz, ptr);
     return 0;
 }
 
+/**
+ * gets the glClearBufferSubData format that stores a 'size' byte pattern
+ * unchanged, or returns false if there is none.
+ */
+static bool glbClearFormat(size_t size, GLenum *internal, GLenum *format, GLenum *type)
+{
+    switch(size)
+    {
+        case 1:
+            *internal = GL_R8UI; *format = GL_RED_INTEGER; *type = GL_UNSIGNED_BYTE;
+            return true;
+        case 2:
+            *internal = GL_R16UI; *format = GL_RED_INTEGER; *type = GL_UNSIGNED_SHORT;
+            return true;
+        case 4:
+            *internal = GL_R32UI; *format = GL_RED_INTEGER; *type = GL_UNSIGNED_INT;
+            return true;
+        case 8:
+            *internal = GL_RG32UI; *format = GL_RG_INTEGER; *type = GL_UNSIGNED_INT;
+            return true;
+        case 16:
+            *internal = GL_RGBA32UI; *format = GL_RGBA_INTEGER; *type = GL_UNSIGNED_INT;
+            return true;
+    }
+    return false;
+}
+
+#define GLB_FILL_CHUNK 4096 ///< bytes of pattern copied into a mapping at once
+
+/**
+ * fills 'size' bytes of the buffer at 'offset' with copies of a pattern. Patterns
+ * of 1, 2, 4, 8 or 16 bytes are cleared on the GPU with glClearBufferSubData if
+ * the range is aligned to the pattern. Otherwise only the range is mapped,
+ * invalidated, and written a chunk of repeated pattern at a time; if 'size' is
+ * not a multiple of the pattern, the last copy is cut short.
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if the range is outside the buffer,
+ * or GLB_MAP_ERROR/GLB_WRITE_ERROR if the mapped write failed.
+ */
 int glbFillBuffer (GLBBuffer *buffer,
                     const void *pattern,
                     size_t pattern_size,
                     size_t offset,
                     size_t size)
 {
-    if(!buffer) return 0;
-    //TODO
-    int complete = 0;
-    int try = 3; // try to fill at most this many times if it fails
-    while (!complete && try--) // should only run once unless theres a write error
+    int errcode;
+    GLB_ASSERT(buffer && pattern && pattern_size, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(offset + size <= buffer->nmemb * buffer->sz && offset + size >= offset,
+               GLB_INVALID_ARGUMENT, ERROR);
+    if(!size) return GLB_SUCCESS;
+
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, buffer->globj);
+
+    GLenum internal, format, type;
+    if(glbClearFormat(pattern_size, &internal, &format, &type) &&
+       (buffer->offset + offset) % pattern_size == 0 && size % pattern_size == 0 &&
+       glbCanUseFeature(GLB_CLEAR_BUFFER_FEATURE))
     {
-        uint8_t *mapped = glbMapBuffer(buffer, GLB_WRITE_ONLY);
-        if(!mapped) return GLB_MAP_ERROR;
+        glClearBufferSubData(GL_COPY_WRITE_BUFFER, internal, buffer->offset + offset, size,
+                             format, type, pattern);
+        glbBufferFenceWrite(buffer);
+        return GLB_SUCCESS;
+    }
+
+    uint8_t *mapped = glbMapBufferRange(buffer, offset, size,
+                                        GLB_MAP_WRITE_BIT | GLB_MAP_INVALIDATE_RANGE_BIT);
+    GLB_ASSERT(mapped, GLB_MAP_ERROR, ERROR);
 
-        int i;
-        for(i = 0; i < size / pattern_size; i++)
+    // the mapping may be write-combined, so the pattern is repeated into a local
+    // chunk by doubling, and the mapping is only ever written
+    uint8_t chunk[GLB_FILL_CHUNK];
+    size_t chunksz = pattern_size;
+    const uint8_t *src = pattern;
+    if(pattern_size <= GLB_FILL_CHUNK / 2)
+    {
+        memcpy(chunk, pattern, pattern_size);
+        while(chunksz * 2 <= GLB_FILL_CHUNK)
         {
-            memcpy(&mapped[offset + i * pattern_size], pattern, pattern_size);
+            memcpy(chunk + chunksz, chunk, chunksz);
+            chunksz *= 2;
         }
-        complete = glbUnmapBuffer(buffer);
+        src = chunk;
     }
 
-    return complete ? GLB_SUCCESS : GLB_WRITE_ERROR;
+    size_t i;
+    for(i = 0; i < size; i += chunksz)
+    {
+        memcpy(mapped + i, src, size - i < chunksz ? size - i : chunksz);
+    }
+
+    // unmapping fences the write
+    GLB_ASSERT(glbUnmapBuffer(buffer), GLB_WRITE_ERROR, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
 }
 
 int glbCopyBuffer (GLBBuffer *src,
@@ -165,27 +583,122 @@ int glbCopyBuffer (GLBBuffer *src,
                     size_t size)
 {
     if(!src || !dst) return 0;
-    glCopyBufferSubData(src->globj, dst->globj, src_offset, dst_offset, size);
+    glbStateBindBuffer(GL_COPY_READ_BUFFER, src->globj);
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, dst->globj);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        src->offset + src_offset, dst->offset + dst_offset, size);
+    glbBufferFenceWrite(dst);
     return 0;
 }
 
+/**
+ * maps the buffer's storage. Only the buffer's own range is mapped, so views of
+ * a GLBBufferHeap can be mapped, but only one view of a heap page at a time.
+ * @param access GLB_READ_ONLY, GLB_WRITE_ONLY or GLB_READ_WRITE
+ */
 void* glbMapBuffer (GLBBuffer *buffer, int access)
 {
     if(!buffer) return 0;
-    return glMapBuffer(buffer->globj, access);
+    // the access flags have the values of GL_MAP_READ_BIT and GL_MAP_WRITE_BIT
+    return glbMapBufferRange(buffer, 0, buffer->nmemb * buffer->sz, access & GLB_READ_WRITE);
+}
+
+/**
+ * maps 'length' bytes of the buffer at 'offset', as glMapBufferRange. Mapping
+ * only the bytes that are written, with the flags below, avoids the implicit
+ * synchronization of mapping the whole buffer:
+ *
+ *  - GLB_MAP_INVALIDATE_RANGE_BIT discards the range, so it needs not be waited
+ *    for or read back. GLB_MAP_INVALIDATE_BUFFER_BIT discards the whole buffer;
+ *    on heap views and dynamic buffers it only discards the range, leaving the
+ *    data sharing the GL buffer alone.
+ *  - GLB_MAP_UNSYNCHRONIZED_BIT never waits; the GPU must not be using the range.
+ *  - GLB_MAP_FLUSH_EXPLICIT_BIT only makes the parts given to
+ *    glbFlushMappedBufferRange visible, so writers can flush what they touched.
+ *
+ * The mapping is ended with glbUnmapBuffer.
+ * @param access GLB_MAP_READ_BIT and/or GLB_MAP_WRITE_BIT, with any enum
+ * GLBMapFlags valid for them
+ * @returns the mapping, or NULL if the range is outside the buffer or GL failed
+ */
+void* glbMapBufferRange (GLBBuffer *buffer, size_t offset, size_t length, int access)
+{
+    if(!buffer || !length || offset + length > buffer->nmemb * buffer->sz ||
+       offset + length < offset)
+    {
+        return NULL;
+    }
+
+    // shared storage is only invalidated in the buffer's range
+    if(!buffer->usage && (access & GLB_MAP_INVALIDATE_BUFFER_BIT))
+    {
+        access = (access & ~GLB_MAP_INVALIDATE_BUFFER_BIT) | GLB_MAP_INVALIDATE_RANGE_BIT;
+    }
+
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, buffer->globj);
+    return glMapBufferRange(GL_COPY_WRITE_BUFFER, buffer->offset + offset, length, access);
+}
+
+/**
+ * makes writes to part of a range mapped with GLB_MAP_FLUSH_EXPLICIT_BIT visible
+ * to GL. Parts that are not flushed are undefined after unmapping.
+ * @param offset byte offset of the part from the start of the mapped range
+ */
+int glbFlushMappedBufferRange (GLBBuffer *buffer, size_t offset, size_t length)
+{
+    if(!buffer) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, buffer->globj);
+    glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, offset, length);
+    return GLB_SUCCESS;
 }
 
 int glbUnmapBuffer (GLBBuffer *buffer)
 {
     if(!buffer) return 0;
-    int err = glUnmapBuffer(buffer->globj);
+    glbStateBindBuffer(GL_COPY_WRITE_BUFFER, buffer->globj);
+    int err = glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glbBufferFenceWrite(buffer);
     return err; //unfortunately there is no way to gaurd against this error
 }
 
+/**
+ * @private
+ * size in bytes of one attribute described by 'layout'.
+ */
+size_t glbVertexLayoutSizeof(const GLBVertexLayout *layout)
+{
+    if(glbTypeIsPacked(layout->type))
+    {
+        return glbTypeSizeof(layout->type);
+    }
+    return layout->size * glbTypeSizeof(layout->type);
+}
+
+/**
+ * @private
+ * deletes all vertex array objects cached for drawing the buffer. Must be
+ * called whenever the vertex layout they were specified with becomes invalid.
+ */
+void glbBufferClearVertexArrays(GLBBuffer *buffer)
+{
+    int i;
+    for(i = 0; i < buffer->nvertexarrays; i++)
+    {
+        glbStateDeleteVertexArray(buffer->vertexarrays[i].globj);
+        glDeleteVertexArrays(1, &buffer->vertexarrays[i].globj);
+    }
+    buffer->nvertexarrays = 0;
+    buffer->nextvertexarray = 0;
+}
+
 int glbVertexBufferFormat (GLBBuffer *buffer, int ndesc, GLBVertexLayout *desc)
 {
     if(!buffer) return 0;
 
+    glbBufferClearVertexArrays(buffer);
+    // vertex arrays of other buffers may read this one as instance attributes
+    buffer->serial = glbGenSerial();
+
     // if zero passed, clear format
     if(!ndesc || !desc)
     {
@@ -203,23 +716,24 @@ int glbVertexBufferFormat (GLBBuffer *buffer, int ndesc, GLBVertexLayout *desc)
         return GLB_INVALID_ARGUMENT;
     }
 
-    if(buffer->vdata.layout)
-    {
-        free(buffer->vdata.layout);
-    }
-
-
     // validate the descriptors
     int i;
     for(i = 0; i < ndesc; i++)
     {
-        if(desc[i].size > 4 ||
-           !glbTypeIsScalar(desc[i].type))
+        // packed types hold 4 components (or GL_BGRA)
+        if(glbTypeIsPacked(desc[i].type) ?
+               (desc[i].size != 4 && desc[i].size != GL_BGRA) :
+               (desc[i].size > 4 || !glbTypeIsScalar(desc[i].type)))
         {
             return GLB_INVALID_ARGUMENT;
         }
     }
 
+    if(buffer->vdata.layout)
+    {
+        free(buffer->vdata.layout);
+    }
+
     buffer->vdata.count = ndesc;
     buffer->vdata.layout = malloc(sizeof(struct GLBVertexLayout) * ndesc);
     memcpy(buffer->vdata.layout, desc, sizeof(struct GLBVertexLayout) * ndesc);
@@ -235,8 +749,70 @@ int glbIndexBufferFormat (GLBBuffer *buffer, int offset, int count, int type)
         return GLB_INVALID_ARGUMENT;
     }
 
+    // clusters index into the previous range
+    glbDeleteClusters(buffer->clusters);
+    buffer->clusters = NULL;
+
     buffer->idata.count = count;
     buffer->idata.offset = offset;
     buffer->idata.type = glbTypeToUnsigned(type);
     return 0;
 }
+
+/**
+ * gets the remap table of a buffer created with GLB_WELD_VERTICES. Entry i is
+ * the index of the stored vertex that the i'th vertex passed in was merged into.
+ * @param nremap optional parameter that returns the number of entries
+ * @returns the remap table, or NULL if the buffer was not welded
+ */
+const unsigned int *glbVertexBufferRemap (GLBBuffer *buffer, size_t *nremap)
+{
+    if(nremap) *nremap = buffer ? buffer->nremap : 0;
+    return buffer ? buffer->remap : NULL;
+}
+
+/**
+ * sets an option of the buffer.
+ * @param option the option to set, from enum GLBBufferOptions
+ * @param value the new value, as described by the option
+ * @returns 0 on success, or GLB_INVALID_ARGUMENT if the option or value is
+ * not recognized.
+ */
+int glbBufferOption (GLBBuffer *buffer, int option, int value)
+{
+    int errcode = GLB_INVALID_ARGUMENT;
+    GLB_ASSERT(buffer, GLB_INVALID_ARGUMENT, ERROR);
+
+    switch(option)
+    {
+        case GLB_NO_BUFFER_OPTIONS:
+            return 0;
+        case GLB_WRITE_MODE:
+            GLB_ASSERT(value >= GLB_WRITE_SYNCHRONIZED && value <= GLB_WRITE_UNSYNCHRONIZED,
+                       GLB_INVALID_ARGUMENT, ERROR);
+            buffer->writemode = value;
+            break;
+        case GLB_FENCE_WRITES:
+            buffer->fencewrites = value ? true : false;
+            break;
+        default:
+            GLB_ASSERT(0, GLB_INVALID_ARGUMENT, ERROR);
+    }
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * gets the fence inserted after the buffer's last write, if writes are fenced
+ * with GLB_FENCE_WRITES. Writes are glbWriteBuffer, glbFillBuffer, copies into
+ * the buffer and unmapping it. Once the fence is signalled the memory the write
+ * read from can be reused, and unsynchronized writes will not race it. The fence
+ * belongs to the buffer and is replaced by the next write; retain it to keep it.
+ * @returns the fence, or NULL if no write has been fenced
+ */
+GLBFence *glbBufferFence (GLBBuffer *buffer)
+{
+    return buffer ? buffer->fence : NULL;
+}
@@ -25,6 +25,50 @@ enum GLBBufferUsage
     GLB_DYNAMIC_COPY = GL_DYNAMIC_COPY,
 };
 
+/**
+ * flags that may be combined with a GLBBufferUsage when creating a buffer.
+ */
+enum GLBBufferFlags
+{
+    GLB_NARROW_INDICES = 0x10000, ///< store 32 bit indices as 16 bit if they fit
+    GLB_WELD_VERTICES  = 0x20000, ///< merge bit-identical vertices, see glbVertexBufferRemap
+};
+
+/**
+ * flags of glbMapBufferRange, as for glMapBufferRange.
+ */
+enum GLBMapFlags
+{
+    GLB_MAP_READ_BIT              = GL_MAP_READ_BIT,
+    GLB_MAP_WRITE_BIT             = GL_MAP_WRITE_BIT,
+    GLB_MAP_INVALIDATE_RANGE_BIT  = GL_MAP_INVALIDATE_RANGE_BIT,  ///< discard the range
+    GLB_MAP_INVALIDATE_BUFFER_BIT = GL_MAP_INVALIDATE_BUFFER_BIT, ///< discard the buffer
+    GLB_MAP_FLUSH_EXPLICIT_BIT    = GL_MAP_FLUSH_EXPLICIT_BIT,    ///< see glbFlushMappedBufferRange
+    GLB_MAP_UNSYNCHRONIZED_BIT    = GL_MAP_UNSYNCHRONIZED_BIT,    ///< never wait for the GPU
+};
+
+/**
+ * options set with glbBufferOption.
+ */
+enum GLBBufferOptions
+{
+    GLB_NO_BUFFER_OPTIONS = 0,
+    GLB_WRITE_MODE        = 1, ///< uses enum GLBWriteModes, the mode of glbWriteBuffer
+    GLB_FENCE_WRITES      = 2, ///< boolean, fence each write, see glbBufferFence
+};
+
+/**
+ * ways of writing to a buffer the GPU may still be reading. Only the synchronized
+ * mode waits for the GPU; the others trade that wait for a promise about the data.
+ */
+enum GLBWriteModes
+{
+    GLB_WRITE_SYNCHRONIZED   = 0, ///< glBufferSubData, waits if the GPU reads the buffer
+    GLB_WRITE_ORPHAN         = 1, ///< whole buffer writes get new storage, others invalidate
+    GLB_WRITE_INVALIDATE     = 2, ///< discards the old contents of the written range first
+    GLB_WRITE_UNSYNCHRONIZED = 3, ///< never waits; the GPU must not be using the range
+};
+
 GLBBuffer* glbCreateBuffer   (size_t nmemb, size_t sz,
                               const void *const ptr, int usage, int *errcode_ret);
 GLBBuffer* glbCreateIndexBuffer  (size_t nmemb, size_t sz, const void * const ptr,
@@ -32,10 +76,15 @@ GLBBuffer* glbCreateIndexBuffer  (size_t nmemb, size_t sz, const void * const pt
 GLBBuffer* glbCreateVertexBuffer (size_t nmemb, size_t sz, const void *const ptr, int ndesc,
                                   struct GLBVertexLayout *desc,
                                   int usage, int *errcode_ret);
+GLBBuffer* glbCreateQuantizedVertexBuffer (size_t nmemb, const void *const ptr, int ndesc,
+                                           struct GLBVertexLayout *desc, const int *precision,
+                                           int usage, int *errcode_ret);
 void       glbDeleteBuffer   (GLBBuffer *buffer);
 void       glbRetainBuffer   (GLBBuffer *buffer);
 void       glbReleaseBuffer  (GLBBuffer *buffer);
 int        glbWriteBuffer    (GLBBuffer *buffer, size_t offset, size_t sz, void *ptr);
+int        glbWriteBufferMode (GLBBuffer *buffer, size_t offset, size_t sz,
+                               const void *ptr, int mode);
 int        glbReadBuffer     (GLBBuffer *buffer, size_t offset, size_t sz, void *ptr);
 int        glbFillBuffer     (GLBBuffer *buffer,
                                const void *pattern,
@@ -48,11 +97,15 @@ int        glbCopyBuffer     (GLBBuffer *src,
                                size_t dst_offset,
                                size_t size);
 void*      glbMapBuffer      (GLBBuffer *buffer, int access);
+void*      glbMapBufferRange (GLBBuffer *buffer, size_t offset, size_t length, int access);
+int        glbFlushMappedBufferRange (GLBBuffer *buffer, size_t offset, size_t length);
 int        glbUnmapBuffer    (GLBBuffer *buffer);
 
 int        glbVertexBufferFormat (GLBBuffer *buffer, int ndesc, struct GLBVertexLayout *desc);
 int        glbIndexBufferFormat  (GLBBuffer *buffer, int offset, int count, int type);
+const unsigned int *glbVertexBufferRemap (GLBBuffer *buffer, size_t *nremap);
 
-int        glbBufferOption       (GLBBuffer *buffer);
+int        glbBufferOption       (GLBBuffer *buffer, int option, int value);
+GLBFence  *glbBufferFence        (GLBBuffer *buffer);
 
 #endif
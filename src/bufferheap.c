@@ -0,0 +1,423 @@
+/**
+ * bufferheap.c
+ * @file bufferheap.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBBufferHeap object interface
+ *
+ * A buffer heap sub-allocates many buffers from a few large GL buffers, called
+ * pages. Each allocation is a GLBBuffer view: an ordinary buffer whose data
+ * starts at an offset into the page, which every buffer operation and draw adds.
+ * Views in the same page share a GL buffer, so drawing them does not rebind it.
+ *
+ * Free ranges are kept in segregated free lists, one per power of two of their
+ * size. An allocation searches its own size class for a fit, then takes the
+ * first block of any larger class, and splits off the rest. Freed blocks are
+ * merged with free neighbours, so the heap never holds two adjacent free blocks.
+ *
+ * glbBufferHeapDefragment compacts the heap incrementally, moving views into
+ * free space nearer the start with GPU copies. Called every frame with a small
+ * budget, it works through fragmentation in the background of rendering.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Free lists*/
+static int glbHeapBin(size_t size)
+{
+    int bin = 0;
+    while(size >>= 1)
+    {
+        bin++;
+    }
+    return bin;
+}
+
+static void glbHeapInsertFree(GLBBufferHeap *heap, struct GLBHeapBlock *block)
+{
+    int bin = glbHeapBin(block->size);
+    block->view = NULL;
+    block->prevfree = NULL;
+    block->nextfree = heap->bins[bin];
+    if(heap->bins[bin])
+    {
+        heap->bins[bin]->prevfree = block;
+    }
+    heap->bins[bin] = block;
+}
+
+static void glbHeapRemoveFree(GLBBufferHeap *heap, struct GLBHeapBlock *block)
+{
+    if(block->prevfree)
+    {
+        block->prevfree->nextfree = block->nextfree;
+    } else
+    {
+        heap->bins[glbHeapBin(block->size)] = block->nextfree;
+    }
+
+    if(block->nextfree)
+    {
+        block->nextfree->prevfree = block->prevfree;
+    }
+}
+
+/**
+ * finds a free block of at least 'size' bytes. Blocks in the size's own class
+ * may be too small and are searched; any block of a larger class fits.
+ */
+static struct GLBHeapBlock *glbHeapFind(GLBBufferHeap *heap, size_t size)
+{
+    int bin = glbHeapBin(size);
+    struct GLBHeapBlock *block;
+    for(block = heap->bins[bin]; block; block = block->nextfree)
+    {
+        if(block->size >= size) return block;
+    }
+
+    for(bin++; bin < GLB_HEAP_BINS; bin++)
+    {
+        if(heap->bins[bin]) return heap->bins[bin];
+    }
+    return NULL;
+}
+
+/**
+ * takes 'size' bytes from the start of a free block, returning the rest to the
+ * free lists.
+ */
+static struct GLBHeapBlock *glbHeapTake(GLBBufferHeap *heap, struct GLBHeapBlock *block,
+                                        size_t size)
+{
+    glbHeapRemoveFree(heap, block);
+
+    if(block->size - size >= GLB_HEAP_ALIGN)
+    {
+        struct GLBHeapBlock *rest = malloc(sizeof(struct GLBHeapBlock));
+        if(rest)
+        {
+            rest->page = block->page;
+            rest->offset = block->offset + size;
+            rest->size = block->size - size;
+            rest->prev = block;
+            rest->next = block->next;
+            if(block->next)
+            {
+                block->next->prev = rest;
+            }
+            block->next = rest;
+            block->size = size;
+            glbHeapInsertFree(heap, rest);
+        }
+    }
+    return block;
+}
+
+/**
+ * @private
+ * returns a view's block to the heap, merging it with free neighbours.
+ */
+void glbBufferHeapFree(GLBBufferHeap *heap, struct GLBHeapBlock *block)
+{
+    struct GLBHeapBlock *next = block->next;
+    if(next && !next->view)
+    {
+        glbHeapRemoveFree(heap, next);
+        block->size += next->size;
+        block->next = next->next;
+        if(next->next)
+        {
+            next->next->prev = block;
+        }
+        free(next);
+    }
+
+    struct GLBHeapBlock *prev = block->prev;
+    if(prev && !prev->view)
+    {
+        glbHeapRemoveFree(heap, prev);
+        prev->size += block->size;
+        prev->next = block->next;
+        if(block->next)
+        {
+            block->next->prev = prev;
+        }
+        free(block);
+        block = prev;
+    }
+
+    glbHeapInsertFree(heap, block);
+}/*}}}*/
+
+/*{{{ Pages*/
+static struct GLBHeapBlock *glbHeapAddPage(GLBBufferHeap *heap, size_t size)
+{
+    struct GLBHeapPage **pages = realloc(heap->pages,
+                                         sizeof(struct GLBHeapPage*) * (heap->npages + 1));
+    if(!pages) return NULL;
+    heap->pages = pages;
+
+    struct GLBHeapPage *page = malloc(sizeof(struct GLBHeapPage));
+    struct GLBHeapBlock *block = malloc(sizeof(struct GLBHeapBlock));
+    if(!page || !block)
+    {
+        free(page);
+        free(block);
+        return NULL;
+    }
+
+    glGenBuffers(1, &page->globj);
+    glbStateBindBuffer(GL_ARRAY_BUFFER, page->globj);
+    glBufferData(GL_ARRAY_BUFFER, size, NULL, heap->usage);
+    page->size = size;
+    page->index = heap->npages;
+    page->first = block;
+    heap->pages[heap->npages++] = page;
+
+    block->page = page;
+    block->offset = 0;
+    block->size = size;
+    block->prev = NULL;
+    block->next = NULL;
+    glbHeapInsertFree(heap, block);
+    return block;
+}
+
+static void glbHeapDeletePage(GLBBufferHeap *heap, struct GLBHeapPage *page)
+{
+    int i;
+    struct GLBHeapBlock *block = page->first;
+    while(block)
+    {
+        struct GLBHeapBlock *next = block->next;
+        if(!block->view)
+        {
+            glbHeapRemoveFree(heap, block);
+        }
+        free(block);
+        block = next;
+    }
+
+    for(i = page->index + 1; i < heap->npages; i++)
+    {
+        heap->pages[i - 1] = heap->pages[i];
+        heap->pages[i - 1]->index = i - 1;
+    }
+    heap->npages--;
+
+    glbStateDeleteBuffer(page->globj);
+    glDeleteBuffers(1, &page->globj);
+    free(page);
+}/*}}}*/
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates an empty buffer heap with a reference count of 1. Each view holds a
+ * reference to its heap, so the heap lives until its last view is deleted.
+ * @param pagesize size of the GL buffers allocated as the heap grows
+ * @param usage a GLBBufferUsage for the pages. Flags such as GLB_NARROW_INDICES
+ * are ignored.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBBufferHeap *glbCreateBufferHeap(size_t pagesize, int usage, int *errcode_ret)
+{
+    int errcode;
+    int i;
+    GLB_ASSERT(pagesize, GLB_INVALID_ARGUMENT, ERROR);
+
+    GLBBufferHeap *heap = malloc(sizeof(GLBBufferHeap));
+    GLB_ASSERT(heap, GLB_OUT_OF_MEMORY, ERROR);
+
+    heap->refcount = 1;
+    heap->pagesize = pagesize;
+    heap->usage = usage & GLB_BUFFER_USAGE_MASK; // flags only apply to glbCreateBuffer
+    heap->npages = 0;
+    heap->pages = NULL;
+    for(i = 0; i < GLB_HEAP_BINS; i++)
+    {
+        heap->bins[i] = NULL;
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return heap;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteBufferHeap(GLBBufferHeap *heap)
+{
+    if(!heap) return;
+    while(heap->npages)
+    {
+        glbHeapDeletePage(heap, heap->pages[heap->npages - 1]);
+    }
+    free(heap->pages);
+    free(heap);
+}
+
+void glbRetainBufferHeap(GLBBufferHeap *heap)
+{
+    if(!heap) return;
+    heap->refcount++;
+}
+
+void glbReleaseBufferHeap(GLBBufferHeap *heap)
+{
+    if(!heap) return;
+    heap->refcount--;
+    if(heap->refcount <= 0)
+    {
+        glbDeleteBufferHeap(heap);
+    }
+}/*}}}*/
+
+/*{{{ Allocation*/
+/**
+ * allocates a buffer of 'nmemb' members of 'sz' bytes from the heap, as
+ * glbCreateBuffer. The buffer is used like any other, and deleting it returns its
+ * range to the heap. Views of the same page can not be mapped at the same time.
+ * @param ptr optional data to initialize the buffer with
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBBuffer *glbBufferHeapAlloc(GLBBufferHeap *heap, size_t nmemb, size_t sz,
+                              const void *ptr, int *errcode_ret)
+{
+    int errcode;
+    GLB_ASSERT(heap && nmemb && sz, GLB_INVALID_ARGUMENT, ERROR);
+
+    size_t size = (nmemb * sz + GLB_HEAP_ALIGN - 1) & ~(size_t) (GLB_HEAP_ALIGN - 1);
+    struct GLBHeapBlock *block = glbHeapFind(heap, size);
+    if(!block)
+    {
+        block = glbHeapAddPage(heap, size > heap->pagesize ? size : heap->pagesize);
+        GLB_ASSERT(block, GLB_OUT_OF_MEMORY, ERROR);
+    }
+
+    GLBBuffer *buffer = glbAllocBuffer(nmemb, sz);
+    GLB_ASSERT(buffer, GLB_OUT_OF_MEMORY, ERROR);
+
+    block = glbHeapTake(heap, block, size);
+    block->view = buffer;
+    buffer->globj = block->page->globj;
+    buffer->offset = block->offset;
+    buffer->heap = heap;
+    buffer->block = block;
+    glbRetainBufferHeap(heap);
+
+    if(ptr)
+    {
+        glbWriteBuffer(buffer, 0, nmemb * sz, (void*) ptr);
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return buffer;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+static bool glbHeapBefore(const struct GLBHeapBlock *a, const struct GLBHeapBlock *b)
+{
+    return a->page->index < b->page->index ||
+           (a->page == b->page && a->offset < b->offset);
+}
+
+/**
+ * finds the first free block, in page and offset order, that is before 'block'
+ * and can hold it. Only the bins that can hold it are searched. It never
+ * overlaps 'block', so the data can be copied.
+ */
+static struct GLBHeapBlock *glbHeapFindBefore(GLBBufferHeap *heap, struct GLBHeapBlock *block)
+{
+    int bin;
+    struct GLBHeapBlock *best = NULL;
+    for(bin = glbHeapBin(block->size); bin < GLB_HEAP_BINS; bin++)
+    {
+        struct GLBHeapBlock *hole;
+        for(hole = heap->bins[bin]; hole; hole = hole->nextfree)
+        {
+            if(hole->size >= block->size && glbHeapBefore(hole, block) &&
+               (!best || glbHeapBefore(hole, best)))
+            {
+                best = hole;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * moves views towards the start of the heap, into free space large enough to
+ * hold them, and deletes pages left empty. The data is copied on the GPU.
+ * Moved views get a new offset, and possibly a new GL buffer; the vertex arrays
+ * using them are rebuilt on their next draw. No view may be mapped.
+ * @param budget the most bytes to move, eg. a few hundred kilobytes per frame
+ * @returns the number of bytes moved
+ */
+size_t glbBufferHeapDefragment(GLBBufferHeap *heap, size_t budget)
+{
+    int i;
+    size_t moved = 0;
+    if(!heap) return 0;
+
+    // a single pass suffices: moving a view only frees space after the holes
+    // already passed, which the views still to come can fill
+    for(i = 0; i < heap->npages && moved < budget; i++)
+    {
+        struct GLBHeapBlock *block = heap->pages[i]->first;
+        while(block && moved < budget)
+        {
+            struct GLBHeapBlock *hole = NULL;
+            if(block->view && moved + block->size <= budget)
+            {
+                hole = glbHeapFindBefore(heap, block);
+            }
+
+            // views are never merged, so the next one survives freeing this block
+            struct GLBHeapBlock *next = block->next;
+            while(next && !next->view)
+            {
+                next = next->next;
+            }
+
+            if(hole)
+            {
+                GLBBuffer *view = block->view;
+                struct GLBHeapBlock *dst = glbHeapTake(heap, hole, block->size);
+                glbStateBindBuffer(GL_COPY_READ_BUFFER, block->page->globj);
+                glbStateBindBuffer(GL_COPY_WRITE_BUFFER, dst->page->globj);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                    block->offset, dst->offset, view->nmemb * view->sz);
+
+                dst->view = view;
+                view->globj = dst->page->globj;
+                view->offset = dst->offset;
+                view->block = dst;
+                // cached vertex arrays hold the old offset, as do those reading it as instances
+                glbBufferClearVertexArrays(view);
+                view->serial = glbGenSerial();
+
+                glbBufferHeapFree(heap, block);
+                moved += dst->size;
+            }
+            block = next;
+        }
+    }
+
+    // pages are only kept while in use, but one stays for new allocations
+    for(i = heap->npages - 1; i > 0; i--)
+    {
+        struct GLBHeapBlock *first = heap->pages[i]->first;
+        if(!first->view && !first->next)
+        {
+            glbHeapDeletePage(heap, heap->pages[i]);
+        }
+    }
+    return moved;
+}/*}}}*/
@@ -0,0 +1,23 @@
+/*
+ * bufferheap.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_BUFFERHEAP_H
+#define _GLB_BUFFERHEAP_H
+
+#include <stddef.h>
+
+#include "glb_types.h"
+
+GLBBufferHeap *glbCreateBufferHeap      (size_t pagesize, int usage, int *errcode_ret);
+void           glbDeleteBufferHeap      (GLBBufferHeap *heap);
+void           glbRetainBufferHeap      (GLBBufferHeap *heap);
+void           glbReleaseBufferHeap     (GLBBufferHeap *heap);
+
+GLBBuffer     *glbBufferHeapAlloc       (GLBBufferHeap *heap, size_t nmemb, size_t sz,
+                                         const void *ptr, int *errcode_ret);
+size_t         glbBufferHeapDefragment  (GLBBufferHeap *heap, size_t budget);
+
+#endif
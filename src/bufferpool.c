@@ -0,0 +1,262 @@
+/**
+ * bufferpool.c
+ * @file bufferpool.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBBufferPool object interface
+ *
+ * A buffer pool recycles buffers, so transient buffers created every frame do
+ * not cost a driver allocation every frame. Buffers from a pool have the storage
+ * of their size class, the next power of two of their size. Deleting (or
+ * releasing) a pooled buffer returns it to the pool with a fence after the draws
+ * that may still read it; it is reused for a buffer of the same size class and
+ * usage once that fence is signalled.
+ *
+ * Free buffers are deleted when they have not been reused for 'maxage' frames,
+ * and the oldest are deleted while more than 'maxbytes' bytes are free.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Size classes*/
+static int glbPoolClass(size_t size)
+{
+    int c = 0;
+    size_t classsize = GLB_POOL_MIN_SIZE;
+    while(classsize < size)
+    {
+        classsize <<= 1;
+        c++;
+    }
+    return c;
+}
+
+static size_t glbPoolClassSize(int c)
+{
+    return (size_t) GLB_POOL_MIN_SIZE << c;
+}
+
+/**
+ * removes a free buffer from its class list. 'prev' is the buffer before it, or
+ * NULL if it is first.
+ */
+static void glbPoolUnlink(GLBBufferPool *pool, int c, GLBBuffer *prev, GLBBuffer *buffer)
+{
+    if(prev)
+    {
+        prev->poolnext = buffer->poolnext;
+    } else
+    {
+        pool->free[c] = buffer->poolnext;
+    }
+
+    if(pool->freetail[c] == buffer)
+    {
+        pool->freetail[c] = prev;
+    }
+    buffer->poolnext = NULL;
+    pool->freebytes -= buffer->capacity;
+}
+
+/**
+ * deletes a free buffer's GL buffer and object.
+ */
+static void glbPoolDestroy(GLBBuffer *buffer)
+{
+    buffer->pool = NULL;
+    glbDeleteBuffer(buffer);
+}/*}}}*/
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates an empty buffer pool with a reference count of 1. Each buffer
+ * acquired from the pool holds a reference to it until the buffer is deleted.
+ * @param maxbytes most bytes kept in free buffers when a frame ends
+ * @param maxage frames a free buffer is kept without being reused, 0 for no limit
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBBufferPool *glbCreateBufferPool(size_t maxbytes, unsigned maxage, int *errcode_ret)
+{
+    int errcode;
+    GLBBufferPool *pool = calloc(1, sizeof(GLBBufferPool));
+    GLB_ASSERT(pool, GLB_OUT_OF_MEMORY, ERROR);
+
+    pool->refcount = 1;
+    pool->maxbytes = maxbytes;
+    pool->maxage = maxage;
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return pool;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteBufferPool(GLBBufferPool *pool)
+{
+    if(!pool) return;
+    glbBufferPoolTrim(pool, 0);
+    free(pool);
+}
+
+void glbRetainBufferPool(GLBBufferPool *pool)
+{
+    if(!pool) return;
+    pool->refcount++;
+}
+
+void glbReleaseBufferPool(GLBBufferPool *pool)
+{
+    if(!pool) return;
+    pool->refcount--;
+    if(pool->refcount <= 0)
+    {
+        glbDeleteBufferPool(pool);
+    }
+}/*}}}*/
+
+/*{{{ Recycling*/
+/**
+ * gets a buffer of 'nmemb' members of 'sz' bytes, as glbCreateBuffer. A free
+ * buffer of the same size class and usage that the GPU is done with is reused;
+ * otherwise a new one is created. Deleting the buffer returns it to the pool.
+ * @param ptr optional data to initialize the buffer with
+ * @param usage a GLBBufferUsage
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBBuffer *glbBufferPoolAcquire(GLBBufferPool *pool, size_t nmemb, size_t sz,
+                                const void *ptr, int usage, int *errcode_ret)
+{
+    int errcode;
+    GLB_ASSERT(pool && nmemb && sz, GLB_INVALID_ARGUMENT, ERROR);
+
+    int c = glbPoolClass(nmemb * sz);
+    GLB_ASSERT(c < GLB_POOL_CLASSES, GLB_INVALID_ARGUMENT, ERROR);
+    usage &= GLB_BUFFER_USAGE_MASK;
+
+    // the list is oldest first, so the first unsignalled fence ends the search
+    GLBBuffer *buffer = pool->free[c];
+    GLBBuffer *prev = NULL;
+    while(buffer && (buffer->usage != usage || !glbFenceSignaled(buffer->fence)))
+    {
+        if(buffer->usage == usage)
+        {
+            buffer = NULL;
+            break;
+        }
+        prev = buffer;
+        buffer = buffer->poolnext;
+    }
+
+    if(buffer)
+    {
+        glbPoolUnlink(pool, c, prev, buffer);
+        glbBufferReset(buffer, nmemb, sz);
+    } else
+    {
+        buffer = glbCreateBuffer(glbPoolClassSize(c), 1, NULL, usage, &errcode);
+        GLB_ASSERT(buffer, errcode, ERROR);
+        glbBufferReset(buffer, nmemb, sz);
+        buffer->pool = pool;
+    }
+    glbRetainBufferPool(pool);
+
+    if(ptr)
+    {
+        glbWriteBuffer(buffer, 0, nmemb * sz, (void*) ptr);
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return buffer;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+/**
+ * @private
+ * takes back a deleted buffer, which glbDeleteBuffer has cleared of its formats.
+ * The buffer is fenced after the commands that may still read it.
+ */
+void glbBufferPoolReturn(GLBBufferPool *pool, GLBBuffer *buffer)
+{
+    int c = glbPoolClass(buffer->capacity);
+    glbFenceReplace(&buffer->fence);
+    buffer->poolframe = pool->frame;
+    buffer->poolnext = NULL;
+
+    if(pool->freetail[c])
+    {
+        pool->freetail[c]->poolnext = buffer;
+    } else
+    {
+        pool->free[c] = buffer;
+    }
+    pool->freetail[c] = buffer;
+    pool->freebytes += buffer->capacity;
+
+    glbReleaseBufferPool(pool);
+}
+
+/**
+ * deletes free buffers, oldest first, until at most 'maxbytes' bytes are free.
+ */
+void glbBufferPoolTrim(GLBBufferPool *pool, size_t maxbytes)
+{
+    int c;
+    if(!pool) return;
+
+    while(pool->freebytes > maxbytes)
+    {
+        // the oldest buffer is first in its class
+        int oldest = -1;
+        for(c = 0; c < GLB_POOL_CLASSES; c++)
+        {
+            if(pool->free[c] && (oldest < 0 ||
+               pool->free[c]->poolframe < pool->free[oldest]->poolframe))
+            {
+                oldest = c;
+            }
+        }
+
+        GLBBuffer *buffer = pool->free[oldest];
+        glbPoolUnlink(pool, oldest, NULL, buffer);
+        glbPoolDestroy(buffer);
+    }
+}
+
+/**
+ * ends a frame: deletes free buffers older than the pool's maximum age, then
+ * trims the pool to its maximum size.
+ */
+void glbBufferPoolFrame(GLBBufferPool *pool)
+{
+    int c;
+    if(!pool) return;
+    pool->frame++;
+
+    for(c = 0; c < GLB_POOL_CLASSES && pool->maxage; c++)
+    {
+        while(pool->free[c] && pool->frame - pool->free[c]->poolframe > pool->maxage)
+        {
+            GLBBuffer *buffer = pool->free[c];
+            glbPoolUnlink(pool, c, NULL, buffer);
+            glbPoolDestroy(buffer);
+        }
+    }
+
+    glbBufferPoolTrim(pool, pool->maxbytes);
+}
+
+/**
+ * gets the number of bytes held by free buffers.
+ */
+size_t glbBufferPoolFreeBytes(GLBBufferPool *pool)
+{
+    return pool ? pool->freebytes : 0;
+}/*}}}*/
@@ -0,0 +1,25 @@
+/*
+ * bufferpool.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_BUFFERPOOL_H
+#define _GLB_BUFFERPOOL_H
+
+#include <stddef.h>
+
+#include "glb_types.h"
+
+GLBBufferPool *glbCreateBufferPool      (size_t maxbytes, unsigned maxage, int *errcode_ret);
+void           glbDeleteBufferPool      (GLBBufferPool *pool);
+void           glbRetainBufferPool      (GLBBufferPool *pool);
+void           glbReleaseBufferPool     (GLBBufferPool *pool);
+
+GLBBuffer     *glbBufferPoolAcquire     (GLBBufferPool *pool, size_t nmemb, size_t sz,
+                                         const void *ptr, int usage, int *errcode_ret);
+void           glbBufferPoolFrame       (GLBBufferPool *pool);
+void           glbBufferPoolTrim        (GLBBufferPool *pool, size_t maxbytes);
+size_t         glbBufferPoolFreeBytes   (GLBBufferPool *pool);
+
+#endif
@@ -0,0 +1,475 @@
+/**
+ * commandlist.c
+ * @file commandlist.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBCommandList object interface
+ *
+ * A command list records uniform updates, texture binds, buffer writes and draws
+ * without calling GL, so that lists can be built on worker threads and executed
+ * later on the GL thread. Each list may only be used by one thread at a time,
+ * but separate lists can be recorded concurrently. Recording does not retain the
+ * objects it references; they must stay alive until the list is executed.
+ *
+ * Commands, and the data they copy, are allocated from chunks owned by the list.
+ * Resetting the list keeps its chunks, so recording a similar frame again does
+ * not allocate.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GLB_COMMAND_CHUNK_SIZE (64 * 1024)
+#define GLB_COMMAND_ALIGN      8
+
+///@private
+enum GLBCommandType
+{
+    GLB_COMMAND_UNIFORM,
+    GLB_COMMAND_UNIFORM_MATRIX,
+    GLB_COMMAND_TEXTURE,
+    GLB_COMMAND_WRITE_BUFFER,
+    GLB_COMMAND_DRAW,
+};
+
+///@private
+struct GLBCommandChunk
+{
+    struct GLBCommandChunk *next;
+    size_t size; ///< bytes available in data
+    size_t used; ///< bytes allocated from data
+    unsigned char *data;
+};
+
+///@private
+struct GLBCommand
+{
+    enum GLBCommandType type;
+    struct GLBCommand *next;
+    union
+    {
+        struct
+        {
+            GLBProgram *program;
+            int shader;
+            int i;
+            size_t sz;
+            bool transpose;
+            void *val;
+        } uniform;
+
+        struct
+        {
+            GLBProgram *program;
+            int shader;
+            int i;
+            GLBTexture *texture;
+        } texture;
+
+        struct
+        {
+            GLBBuffer *buffer;
+            size_t offset;
+            size_t sz;
+            void *ptr;
+        } write;
+
+        GLBDrawItem draw;
+    } u;
+};
+
+/*{{{ Arena*/
+static struct GLBCommandChunk *glbCreateCommandChunk(size_t size)
+{
+    struct GLBCommandChunk *chunk = malloc(sizeof(struct GLBCommandChunk) + size);
+    if(!chunk) return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->data = (unsigned char*) (chunk + 1);
+    return chunk;
+}
+
+/**
+ * allocates 'sz' bytes from the list's chunks. Moves on to the next chunk when
+ * the current one is full, and only allocates a chunk once all are in use.
+ * @returns the allocation, or NULL if out of memory
+ */
+static void *glbCommandListAlloc(GLBCommandList *list, size_t sz)
+{
+    sz = (sz + GLB_COMMAND_ALIGN - 1) & ~(size_t) (GLB_COMMAND_ALIGN - 1);
+
+    struct GLBCommandChunk *chunk = list->chunk;
+    while(chunk && chunk->used + sz > chunk->size)
+    {
+        chunk = chunk->next;
+        if(chunk)
+        {
+            chunk->used = 0;
+        }
+    }
+
+    if(!chunk)
+    {
+        chunk = glbCreateCommandChunk(sz > GLB_COMMAND_CHUNK_SIZE ? sz : GLB_COMMAND_CHUNK_SIZE);
+        if(!chunk) return NULL;
+
+        // keep all chunks after the current one, so they are reused after a reset
+        if(list->chunk)
+        {
+            chunk->next = list->chunk->next;
+            list->chunk->next = chunk;
+        } else
+        {
+            list->chunks = chunk;
+        }
+    }
+
+    list->chunk = chunk;
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += sz;
+    return ptr;
+}
+
+static void *glbCommandListCopy(GLBCommandList *list, const void *ptr, size_t sz)
+{
+    void *copy = glbCommandListAlloc(list, sz);
+    if(copy && sz)
+    {
+        memcpy(copy, ptr, sz);
+    }
+    return copy;
+}
+
+static struct GLBCommand *glbCommandListPush(GLBCommandList *list, enum GLBCommandType type)
+{
+    struct GLBCommand *cmd = glbCommandListAlloc(list, sizeof(struct GLBCommand));
+    if(!cmd) return NULL;
+
+    cmd->type = type;
+    cmd->next = NULL;
+    if(list->last)
+    {
+        list->last->next = cmd;
+    } else
+    {
+        list->first = cmd;
+    }
+    list->last = cmd;
+    list->ncommands++;
+    return cmd;
+}/*}}}*/
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates a new, empty command list with a reference count of 1.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBCommandList *glbCreateCommandList(int *errcode_ret)
+{
+    int errcode;
+    GLBCommandList *list = malloc(sizeof(GLBCommandList));
+    GLB_ASSERT(list, GLB_OUT_OF_MEMORY, ERROR);
+
+    list->refcount = 1;
+    list->chunks = NULL;
+    list->chunk = NULL;
+    list->first = NULL;
+    list->last = NULL;
+    list->ncommands = 0;
+    list->ndraws = 0;
+    list->maxdraws = 0;
+    list->draws = NULL;
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return list;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteCommandList(GLBCommandList *list)
+{
+    if(!list) return;
+
+    struct GLBCommandChunk *chunk = list->chunks;
+    while(chunk)
+    {
+        struct GLBCommandChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(list->draws);
+    free(list);
+}
+
+void glbRetainCommandList(GLBCommandList *list)
+{
+    if(!list) return;
+    list->refcount++;
+}
+
+void glbReleaseCommandList(GLBCommandList *list)
+{
+    if(!list) return;
+    list->refcount--;
+    if(list->refcount <= 0)
+    {
+        glbDeleteCommandList(list);
+    }
+}/*}}}*/
+
+/*{{{ Recording*/
+/**
+ * records a glbProgramUniform call. The value is copied.
+ */
+int glbCommandListUniform(GLBCommandList *list, GLBProgram *program,
+                          int shader, int i, int sz, const void *val)
+{
+    int errcode;
+    GLB_ASSERT(list && program && val && sz > 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBCommand *cmd = glbCommandListPush(list, GLB_COMMAND_UNIFORM);
+    GLB_ASSERT(cmd, GLB_OUT_OF_MEMORY, ERROR);
+
+    cmd->u.uniform.program = program;
+    cmd->u.uniform.shader = shader;
+    cmd->u.uniform.i = i;
+    cmd->u.uniform.sz = sz;
+    cmd->u.uniform.transpose = false;
+    cmd->u.uniform.val = glbCommandListCopy(list, val, sz);
+    GLB_ASSERT(cmd->u.uniform.val, GLB_OUT_OF_MEMORY, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * records a glbProgramUniformMatrix call. The value is copied.
+ */
+int glbCommandListUniformMatrix(GLBCommandList *list, GLBProgram *program,
+                                int shader, int i, size_t sz, bool transpose,
+                                const void *val)
+{
+    int errcode;
+    GLB_ASSERT(list && program && val && sz > 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBCommand *cmd = glbCommandListPush(list, GLB_COMMAND_UNIFORM_MATRIX);
+    GLB_ASSERT(cmd, GLB_OUT_OF_MEMORY, ERROR);
+
+    cmd->u.uniform.program = program;
+    cmd->u.uniform.shader = shader;
+    cmd->u.uniform.i = i;
+    cmd->u.uniform.sz = sz;
+    cmd->u.uniform.transpose = transpose;
+    cmd->u.uniform.val = glbCommandListCopy(list, val, sz);
+    GLB_ASSERT(cmd->u.uniform.val, GLB_OUT_OF_MEMORY, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * records a glbProgramTexture call.
+ */
+int glbCommandListTexture(GLBCommandList *list, GLBProgram *program,
+                          int shader, int i, GLBTexture *texture)
+{
+    int errcode;
+    GLB_ASSERT(list && program, GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBCommand *cmd = glbCommandListPush(list, GLB_COMMAND_TEXTURE);
+    GLB_ASSERT(cmd, GLB_OUT_OF_MEMORY, ERROR);
+
+    cmd->u.texture.program = program;
+    cmd->u.texture.shader = shader;
+    cmd->u.texture.i = i;
+    cmd->u.texture.texture = texture;
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * records a glbWriteBuffer call. The data is copied.
+ */
+int glbCommandListWriteBuffer(GLBCommandList *list, GLBBuffer *buffer,
+                              size_t offset, size_t sz, const void *ptr)
+{
+    int errcode;
+    GLB_ASSERT(list && buffer && (ptr || !sz), GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBCommand *cmd = glbCommandListPush(list, GLB_COMMAND_WRITE_BUFFER);
+    GLB_ASSERT(cmd, GLB_OUT_OF_MEMORY, ERROR);
+
+    cmd->u.write.buffer = buffer;
+    cmd->u.write.offset = offset;
+    cmd->u.write.sz = sz;
+    cmd->u.write.ptr = glbCommandListCopy(list, ptr, sz);
+    GLB_ASSERT(cmd->u.write.ptr, GLB_OUT_OF_MEMORY, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * records a draw, as for glbProgramDrawBatch. The item, its uniform and texture
+ * lists and the uniform values are copied.
+ */
+int glbCommandListDraw(GLBCommandList *list, const GLBDrawItem *item)
+{
+    int errcode;
+    int i;
+    GLB_ASSERT(list && item && item->program && item->array, GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBCommand *cmd = glbCommandListPush(list, GLB_COMMAND_DRAW);
+    GLB_ASSERT(cmd, GLB_OUT_OF_MEMORY, ERROR);
+
+    GLBDrawItem *draw = &cmd->u.draw;
+    *draw = *item;
+
+    if(item->nuniforms)
+    {
+        draw->uniforms = glbCommandListCopy(list, item->uniforms,
+                                            sizeof(GLBDrawUniform) * item->nuniforms);
+        GLB_ASSERT(draw->uniforms, GLB_OUT_OF_MEMORY, ERROR);
+        for(i = 0; i < item->nuniforms; i++)
+        {
+            draw->uniforms[i].val = glbCommandListCopy(list, item->uniforms[i].val,
+                                                       item->uniforms[i].sz);
+            GLB_ASSERT(draw->uniforms[i].val, GLB_OUT_OF_MEMORY, ERROR);
+        }
+    }
+
+    if(item->ntextures)
+    {
+        draw->textures = glbCommandListCopy(list, item->textures,
+                                            sizeof(GLBDrawTexture) * item->ntextures);
+        GLB_ASSERT(draw->textures, GLB_OUT_OF_MEMORY, ERROR);
+    }
+
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * discards all recorded commands. The memory they used is kept for the next
+ * recording.
+ */
+void glbCommandListReset(GLBCommandList *list)
+{
+    if(!list) return;
+
+    list->chunk = list->chunks;
+    if(list->chunk)
+    {
+        list->chunk->used = 0;
+    }
+    list->first = NULL;
+    list->last = NULL;
+    list->ncommands = 0;
+}/*}}}*/
+
+/*{{{ Execution*/
+/**
+ * submits the draws gathered since the last flush as a single batch, so that
+ * consecutive draws share program and vertex array setup.
+ */
+static int glbCommandListFlushDraws(GLBCommandList *list)
+{
+    int errcode = 0;
+    if(list->ndraws)
+    {
+        errcode = glbProgramDrawBatch(list->draws, list->ndraws);
+        list->ndraws = 0;
+    }
+    return errcode;
+}
+
+static int glbCommandListQueueDraw(GLBCommandList *list, const GLBDrawItem *item)
+{
+    if(list->ndraws >= list->maxdraws)
+    {
+        int max = list->maxdraws ? list->maxdraws * 2 : 64;
+        GLBDrawItem *tmp = realloc(list->draws, sizeof(GLBDrawItem) * max);
+        if(!tmp) return GLB_OUT_OF_MEMORY;
+        list->draws = tmp;
+        list->maxdraws = max;
+    }
+
+    list->draws[list->ndraws++] = *item;
+    return GLB_SUCCESS;
+}
+
+/**
+ * executes the recorded commands in order. Must be called on the GL thread.
+ * The list keeps its commands, so it may be executed again; call
+ * glbCommandListReset before recording the next frame.
+ * @returns 0 on success, or the first error encountered. Commands before the
+ * failing command will have been executed.
+ */
+int glbCommandListExecute(GLBCommandList *list)
+{
+    int errcode = 0;
+    struct GLBCommand *cmd;
+    GLB_ASSERT(list, GLB_INVALID_ARGUMENT, ERROR);
+
+    list->ndraws = 0;
+    for(cmd = list->first; cmd; cmd = cmd->next)
+    {
+        if(cmd->type == GLB_COMMAND_DRAW)
+        {
+            errcode = glbCommandListQueueDraw(list, &cmd->u.draw);
+            GLB_ASSERT(!errcode, errcode, ERROR);
+            continue;
+        }
+
+        // other commands may change state the gathered draws depend on
+        errcode = glbCommandListFlushDraws(list);
+        GLB_ASSERT(!errcode, errcode, ERROR);
+
+        switch(cmd->type)
+        {
+            case GLB_COMMAND_UNIFORM:
+                errcode = glbProgramUniform(cmd->u.uniform.program, cmd->u.uniform.shader,
+                                            cmd->u.uniform.i, cmd->u.uniform.sz,
+                                            cmd->u.uniform.val);
+                break;
+            case GLB_COMMAND_UNIFORM_MATRIX:
+                errcode = glbProgramUniformMatrix(cmd->u.uniform.program, cmd->u.uniform.shader,
+                                                  cmd->u.uniform.i, cmd->u.uniform.sz,
+                                                  cmd->u.uniform.transpose, cmd->u.uniform.val);
+                break;
+            case GLB_COMMAND_TEXTURE:
+                errcode = glbProgramTexture(cmd->u.texture.program, cmd->u.texture.shader,
+                                            cmd->u.texture.i, cmd->u.texture.texture);
+                break;
+            case GLB_COMMAND_WRITE_BUFFER:
+                errcode = glbWriteBuffer(cmd->u.write.buffer, cmd->u.write.offset,
+                                         cmd->u.write.sz, cmd->u.write.ptr);
+                break;
+            default:
+                break;
+        }
+        GLB_ASSERT(!errcode, errcode, ERROR);
+    }
+
+    errcode = glbCommandListFlushDraws(list);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}/*}}}*/
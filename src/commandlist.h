@@ -0,0 +1,38 @@
+/*
+ * commandlist.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_COMMANDLIST_H
+#define _GLB_COMMANDLIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "glb_types.h"
+
+GLBCommandList *glbCreateCommandList         (int *errcode_ret);
+void            glbDeleteCommandList         (GLBCommandList *list);
+void            glbRetainCommandList         (GLBCommandList *list);
+void            glbReleaseCommandList        (GLBCommandList *list);
+
+// Recording, does not call GL
+
+int             glbCommandListUniform        (GLBCommandList *list, GLBProgram *program,
+                                              int shader, int i, int sz, const void *val);
+int             glbCommandListUniformMatrix  (GLBCommandList *list, GLBProgram *program,
+                                              int shader, int i, size_t sz, bool transpose,
+                                              const void *val);
+int             glbCommandListTexture        (GLBCommandList *list, GLBProgram *program,
+                                              int shader, int i, GLBTexture *texture);
+int             glbCommandListWriteBuffer    (GLBCommandList *list, GLBBuffer *buffer,
+                                              size_t offset, size_t sz, const void *ptr);
+int             glbCommandListDraw           (GLBCommandList *list, const GLBDrawItem *item);
+void            glbCommandListReset          (GLBCommandList *list);
+
+// Execution, on the GL thread
+
+int             glbCommandListExecute        (GLBCommandList *list);
+
+#endif
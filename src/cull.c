@@ -0,0 +1,163 @@
+/**
+ * cull.c
+ * @file cull.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief frustum culling of flat bounding volume arrays
+ *
+ * Each volume is tested against the 6 planes of a frustum. A sphere is outside a
+ * plane if its center is further than its radius behind it; a box is outside if
+ * its center is further behind it than the box's extent projected on the plane
+ * normal. Volumes are tested 8 at a time with AVX, or 4 at a time with SSE, and
+ * the indices of visible ones are written without branching on the result.
+ */
+
+#include "glb_private.h"
+
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+/*{{{ Kernels*/
+static bool glbBoundsVisible(const float planes[6][4], const GLBBounds *bounds, int i)
+{
+    int p;
+    float x = bounds->x[i], y = bounds->y[i], z = bounds->z[i];
+    for(p = 0; p < 6; p++)
+    {
+        const float *plane = planes[p];
+        float r = bounds->type == GLB_BOUNDS_AABB ?
+                  fabsf(plane[0]) * bounds->ex[i] +
+                  fabsf(plane[1]) * bounds->ey[i] +
+                  fabsf(plane[2]) * bounds->ez[i] :
+                  bounds->radius[i];
+        // same operation order and NaN handling as the vector kernels
+        float d = (plane[0] * x + plane[1] * y) + (plane[2] * z + plane[3]);
+        if(!(d + r >= 0.0f))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(__AVX__)
+#define GLB_CULL_WIDTH 8
+static int glbCullWide(const float planes[6][4], const GLBBounds *bounds, int i)
+{
+    int p;
+    __m256 x = _mm256_loadu_ps(&bounds->x[i]);
+    __m256 y = _mm256_loadu_ps(&bounds->y[i]);
+    __m256 z = _mm256_loadu_ps(&bounds->z[i]);
+    __m256 inside = _mm256_cmp_ps(x, x, _CMP_EQ_OQ); // all ones, except for NaN centers
+    for(p = 0; p < 6; p++)
+    {
+        const float *plane = planes[p];
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), x),
+                                               _mm256_mul_ps(_mm256_set1_ps(plane[1]), y)),
+                                 _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[2]), z),
+                                               _mm256_set1_ps(plane[3])));
+        __m256 r;
+        if(bounds->type == GLB_BOUNDS_AABB)
+        {
+            r = _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[0])), _mm256_loadu_ps(&bounds->ex[i])),
+                    _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[1])), _mm256_loadu_ps(&bounds->ey[i]))),
+                    _mm256_mul_ps(_mm256_set1_ps(fabsf(plane[2])), _mm256_loadu_ps(&bounds->ez[i])));
+        } else
+        {
+            r = _mm256_loadu_ps(&bounds->radius[i]);
+        }
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r),
+                                                     _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+    return _mm256_movemask_ps(inside);
+}
+#elif defined(__SSE__)
+#define GLB_CULL_WIDTH 4
+static int glbCullWide(const float planes[6][4], const GLBBounds *bounds, int i)
+{
+    int p;
+    __m128 x = _mm_loadu_ps(&bounds->x[i]);
+    __m128 y = _mm_loadu_ps(&bounds->y[i]);
+    __m128 z = _mm_loadu_ps(&bounds->z[i]);
+    __m128 inside = _mm_cmpeq_ps(x, x); // all ones, except for NaN centers
+    for(p = 0; p < 6; p++)
+    {
+        const float *plane = planes[p];
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x),
+                                         _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), z),
+                                         _mm_set1_ps(plane[3])));
+        __m128 r;
+        if(bounds->type == GLB_BOUNDS_AABB)
+        {
+            r = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(fabsf(plane[0])), _mm_loadu_ps(&bounds->ex[i])),
+                    _mm_mul_ps(_mm_set1_ps(fabsf(plane[1])), _mm_loadu_ps(&bounds->ey[i]))),
+                    _mm_mul_ps(_mm_set1_ps(fabsf(plane[2])), _mm_loadu_ps(&bounds->ez[i])));
+        } else
+        {
+            r = _mm_loadu_ps(&bounds->radius[i]);
+        }
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+    }
+    return _mm_movemask_ps(inside);
+}
+#endif/*}}}*/
+
+/*{{{ Culling*/
+/**
+ * tests 'n' bounding volumes against a frustum, and writes the indices of those
+ * at least partly inside it, in increasing order.
+ * @param planes the frustum planes (a, b, c, d), with a * x + b * y + c * z + d >= 0
+ * inside. They need not be normalized for boxes, but must be for spheres.
+ * @param bounds the volumes to test
+ * @param visible_out receives up to 'n' indices
+ * @returns the number of visible volumes, or 0 if an argument is invalid
+ */
+int glbCullFrustum(const float planes[6][4], const GLBBounds *bounds,
+                   int n, uint32_t *visible_out)
+{
+    return glbCullFrustumRange(planes, bounds, 0, n, visible_out);
+}
+
+/**
+ * culls the volumes 'first' to 'first' + 'n' - 1, as glbCullFrustum. The indices
+ * written are indices into 'bounds', not into the range. GLB does not own any
+ * threads; to cull across a thread pool, give each job a disjoint range and its
+ * own output, then concatenate the outputs in range order.
+ */
+int glbCullFrustumRange(const float planes[6][4], const GLBBounds *bounds,
+                        int first, int n, uint32_t *visible_out)
+{
+    int i = first;
+    int end = first + n;
+    int nvisible = 0;
+    if(!planes || !bounds || !visible_out || first < 0 || n <= 0) return 0;
+
+#ifdef GLB_CULL_WIDTH
+    for(; i + GLB_CULL_WIDTH <= end; i += GLB_CULL_WIDTH)
+    {
+        int j;
+        int mask = glbCullWide(planes, bounds, i);
+        for(j = 0; j < GLB_CULL_WIDTH; j++)
+        {
+            visible_out[nvisible] = i + j;
+            nvisible += (mask >> j) & 1;
+        }
+    }
+#endif
+
+    for(; i < end; i++)
+    {
+        visible_out[nvisible] = i;
+        nvisible += glbBoundsVisible(planes, bounds, i);
+    }
+    return nvisible;
+}/*}}}*/
@@ -0,0 +1,37 @@
+/*
+ * cull.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_CULL_H
+#define _GLB_CULL_H
+
+#include <stdint.h>
+
+#include "glb_types.h"
+
+enum GLBBoundsType
+{
+    GLB_BOUNDS_SPHERE = 0, ///< centers and radius
+    GLB_BOUNDS_AABB   = 1, ///< centers and half extents
+};
+
+/**
+ * bounding volumes of many objects, as a structure of arrays. All arrays are
+ * indexed by object; only those used by 'type' need to be set.
+ */
+struct GLBBounds
+{
+    int type;              ///< a GLBBoundsType
+    const float *x, *y, *z; ///< centers
+    const float *radius;   ///< sphere radii
+    const float *ex, *ey, *ez; ///< box half extents along each axis
+};
+
+int glbCullFrustum      (const float planes[6][4], const GLBBounds *bounds,
+                         int n, uint32_t *visible_out);
+int glbCullFrustumRange (const float planes[6][4], const GLBBounds *bounds,
+                         int first, int n, uint32_t *visible_out);
+
+#endif
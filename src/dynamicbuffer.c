@@ -0,0 +1,137 @@
+/**
+ * dynamicbuffer.c
+ * @file dynamicbuffer.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBDynamicBuffer object interface
+ *
+ * A dynamic buffer holds data rewritten every frame, such as per-frame vertices,
+ * without the CPU waiting for the GPU to finish drawing the previous frame's
+ * copy. One GL buffer is split into N regions holding N copies of the data. The
+ * dynamic buffer's GLBBuffer always refers to the current region, so it can be
+ * given a layout once and then written and drawn like any other buffer.
+ *
+ * glbDynamicBufferAdvance ends the frame: it fences the current region and moves
+ * the buffer to the next, waiting on that region's fence from N frames ago,
+ * which has normally long been signalled. Since the GPU is then done with the
+ * region, writes skip synchronization.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates a dynamic buffer of 'nregions' copies of 'nmemb' members of 'sz'
+ * bytes. 3 regions let the CPU run 2 frames ahead of the GPU.
+ * @param usage a GLBBufferUsage, usually GLB_DYNAMIC_DRAW or GLB_STREAM_DRAW
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBDynamicBuffer *glbCreateDynamicBuffer(size_t nmemb, size_t sz, int nregions,
+                                         int usage, int *errcode_ret)
+{
+    int errcode;
+    GLBDynamicBuffer *dynamic = NULL;
+    GLB_ASSERT(nmemb && sz && nregions > 0 && nregions <= GLB_MAX_DYNAMIC_REGIONS,
+               GLB_INVALID_ARGUMENT, ERROR);
+
+    dynamic = calloc(1, sizeof(GLBDynamicBuffer));
+    GLB_ASSERT(dynamic, GLB_OUT_OF_MEMORY, ERROR);
+    dynamic->refcount = 1;
+    dynamic->nregions = nregions;
+    dynamic->regionsize = (nmemb * sz + GLB_DYNAMIC_ALIGN - 1) & ~(size_t) (GLB_DYNAMIC_ALIGN - 1);
+
+    dynamic->buffer = glbCreateBuffer(dynamic->regionsize * nregions, 1, NULL, usage, &errcode);
+    GLB_ASSERT(dynamic->buffer, errcode, ERROR);
+    glbBufferReset(dynamic->buffer, nmemb, sz);
+
+    // the regions share the storage, so it is never re-specified; the fences
+    // keep the GPU off the current region, so writes need no synchronization
+    dynamic->buffer->usage = 0;
+    dynamic->buffer->writemode = GLB_WRITE_UNSYNCHRONIZED;
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return dynamic;
+
+ERROR:
+    glbDeleteDynamicBuffer(dynamic);
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteDynamicBuffer(GLBDynamicBuffer *dynamic)
+{
+    int i;
+    if(!dynamic) return;
+    for(i = 0; i < GLB_MAX_DYNAMIC_REGIONS; i++)
+    {
+        glbReleaseFence(dynamic->fences[i]);
+    }
+    glbReleaseBuffer(dynamic->buffer);
+    free(dynamic);
+}
+
+void glbRetainDynamicBuffer(GLBDynamicBuffer *dynamic)
+{
+    if(!dynamic) return;
+    dynamic->refcount++;
+}
+
+void glbReleaseDynamicBuffer(GLBDynamicBuffer *dynamic)
+{
+    if(!dynamic) return;
+    dynamic->refcount--;
+    if(dynamic->refcount <= 0)
+    {
+        glbDeleteDynamicBuffer(dynamic);
+    }
+}/*}}}*/
+
+/*{{{ Frames*/
+/**
+ * ends the frame, after all draws reading the current region are issued. The
+ * region is fenced, and the buffer moves to the next region once the GPU is done
+ * drawing from it. The new region holds the data written 'nregions' frames ago.
+ */
+int glbDynamicBufferAdvance(GLBDynamicBuffer *dynamic)
+{
+    int errcode;
+    GLB_ASSERT(dynamic, GLB_INVALID_ARGUMENT, ERROR);
+
+    glbFenceReplace(&dynamic->fences[dynamic->region]);
+    dynamic->region = (dynamic->region + 1) % dynamic->nregions;
+
+    GLBFence *fence = dynamic->fences[dynamic->region];
+    if(fence)
+    {
+        errcode = glbFenceWait(fence, GL_TIMEOUT_IGNORED);
+        GLB_ASSERT(!errcode, errcode, ERROR);
+    }
+
+    // cached vertex arrays are keyed by offset, so each region keeps its own
+    dynamic->buffer->offset = dynamic->region * dynamic->regionsize;
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * gets the buffer referring to the current region, to write, format and draw.
+ * The buffer is owned by the dynamic buffer. Writes go through an unsynchronized
+ * mapping unless another GLB_WRITE_MODE is set.
+ */
+GLBBuffer *glbDynamicBufferBuffer(GLBDynamicBuffer *dynamic)
+{
+    return dynamic ? dynamic->buffer : NULL;
+}
+
+/**
+ * gets the index of the current region.
+ */
+int glbDynamicBufferRegion(GLBDynamicBuffer *dynamic)
+{
+    return dynamic ? dynamic->region : 0;
+}/*}}}*/
@@ -0,0 +1,24 @@
+/*
+ * dynamicbuffer.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_DYNAMICBUFFER_H
+#define _GLB_DYNAMICBUFFER_H
+
+#include <stddef.h>
+
+#include "glb_types.h"
+
+GLBDynamicBuffer *glbCreateDynamicBuffer   (size_t nmemb, size_t sz, int nregions,
+                                            int usage, int *errcode_ret);
+void              glbDeleteDynamicBuffer   (GLBDynamicBuffer *dynamic);
+void              glbRetainDynamicBuffer   (GLBDynamicBuffer *dynamic);
+void              glbReleaseDynamicBuffer  (GLBDynamicBuffer *dynamic);
+
+int               glbDynamicBufferAdvance  (GLBDynamicBuffer *dynamic);
+GLBBuffer        *glbDynamicBufferBuffer   (GLBDynamicBuffer *dynamic);
+int               glbDynamicBufferRegion   (GLBDynamicBuffer *dynamic);
+
+#endif
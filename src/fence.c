@@ -0,0 +1,118 @@
+/**
+ * fence.c
+ * @file fence.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBFence object interface
+ *
+ * A fence marks a point in the GL command stream. It is signalled once the GPU
+ * has finished every command issued before it, after which memory those commands
+ * read, such as a mapping or a staging buffer, can be reused without glFinish.
+ * Without sync objects (before GL 3.2) waiting on a fence calls glFinish.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * inserts a fence after the commands issued so far, with a reference count of 1.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBFence *glbCreateFence(int *errcode_ret)
+{
+    int errcode;
+    GLBFence *fence = malloc(sizeof(GLBFence));
+    GLB_ASSERT(fence, GLB_OUT_OF_MEMORY, ERROR);
+
+    fence->refcount = 1;
+    fence->signaled = false;
+    fence->sync = NULL;
+    if(glbCanUseFeature(GLB_SYNC_FEATURE))
+    {
+        fence->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return fence;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteFence(GLBFence *fence)
+{
+    if(!fence) return;
+    glDeleteSync(fence->sync);
+    free(fence);
+}
+
+void glbRetainFence(GLBFence *fence)
+{
+    if(!fence) return;
+    fence->refcount++;
+}
+
+void glbReleaseFence(GLBFence *fence)
+{
+    if(!fence) return;
+    fence->refcount--;
+    if(fence->refcount <= 0)
+    {
+        glbDeleteFence(fence);
+    }
+}/*}}}*/
+
+/*{{{ Waiting*/
+/**
+ * waits up to 'timeout' nanoseconds for the fence to be signalled. A timeout of
+ * 0 only polls. Waiting flushes the GL commands, so the fence is sure to be
+ * reached.
+ * @returns 0 once the fence is signalled, or GLB_TIMEOUT
+ */
+int glbFenceWait(GLBFence *fence, uint64_t timeout)
+{
+    if(!fence) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    if(fence->signaled) return GLB_SUCCESS;
+
+    if(!fence->sync)
+    {
+        glFinish();
+        fence->signaled = true;
+        return GLB_SUCCESS;
+    }
+
+    GLenum status = glClientWaitSync(fence->sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(status == GL_TIMEOUT_EXPIRED)
+    {
+        return GLB_TIMEOUT;
+    }
+
+    // the sync object is not needed once signalled
+    glDeleteSync(fence->sync);
+    fence->sync = NULL;
+    fence->signaled = true;
+    GLB_RETURN_ERROR(status == GL_WAIT_FAILED ? GLB_UNKNOWN_ERROR : GLB_SUCCESS);
+}
+
+/**
+ * polls the fence without waiting, except without sync objects.
+ * @returns true if the fence is signalled
+ */
+bool glbFenceSignaled(GLBFence *fence)
+{
+    return fence && glbFenceWait(fence, 0) == GLB_SUCCESS;
+}
+
+/**
+ * @private
+ * replaces '*fence' with a new fence, used by objects that fence their writes.
+ */
+void glbFenceReplace(GLBFence **fence)
+{
+    glbReleaseFence(*fence);
+    *fence = glbCreateFence(NULL);
+}/*}}}*/
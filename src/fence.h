@@ -0,0 +1,23 @@
+/*
+ * fence.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_FENCE_H
+#define _GLB_FENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "glb_types.h"
+
+GLBFence *glbCreateFence      (int *errcode_ret);
+void      glbDeleteFence      (GLBFence *fence);
+void      glbRetainFence      (GLBFence *fence);
+void      glbReleaseFence     (GLBFence *fence);
+
+int       glbFenceWait        (GLBFence *fence, uint64_t timeout);
+bool      glbFenceSignaled    (GLBFence *fence);
+
+#endif
@@ -21,6 +21,9 @@ GLBFramebuffer *glbCreateFramebuffer(int *errcode_ret)
     GLB_ASSERT(framebuffer, GLB_OUT_OF_MEMORY, ERROR);
 
     framebuffer->ncolors = 0;
+    framebuffer->version = glbGenSerial();
+    framebuffer->drawprogram = 0;
+    framebuffer->drawversion = 0;
     framebuffer->refcount = 1;
     framebuffer->depth = NULL;
     framebuffer->stencil = NULL;
@@ -52,6 +55,9 @@ void glbDeleteFramebuffer(GLBFramebuffer *framebuffer)
         glbReleaseTexture(framebuffer->stencil);
     }
 
+    glbStateDeleteFramebuffer(framebuffer->globj);
+    glDeleteFramebuffers(1, &framebuffer->globj);
+    free(framebuffer->colors);
     free(framebuffer);
 }
 
@@ -121,7 +127,7 @@ static int glbFramebufferAttachment(GLBFramebuffer *framebuffer,
                                         GLenum attachment, GLBTexture *texture)
 {
     if(!framebuffer) return 0;
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->globj);
+    glbStateBindFramebuffer(framebuffer->globj);
     switch(texture->target)
     {
         case GL_TEXTURE_1D:
@@ -139,7 +145,7 @@ static int glbFramebufferAttachment(GLBFramebuffer *framebuffer,
             break;
     }
     framebuffer->status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    framebuffer->version = glbGenSerial(); // invalidates draw buffers computed by programs
 
     return GLB_SUCCESS;
 }
@@ -154,7 +160,7 @@ static int glbFramebufferAttachment(GLBFramebuffer *framebuffer,
 int glbFramebufferColor(GLBFramebuffer *framebuffer, int i, GLBTexture *texture)
 {
     if(!framebuffer) return 0;
-    if(i > GLB_FRAMEBUFFER_COLORS_MAX)
+    if(i < 0 || i >= GLB_FRAMEBUFFER_COLORS_MAX)
     {
         return GLB_INVALID_ARGUMENT;
     }
@@ -162,6 +168,10 @@ int glbFramebufferColor(GLBFramebuffer *framebuffer, int i, GLBTexture *texture)
     glbRetainTexture(texture);
     glbReleaseTexture(framebuffer->colors[i]);
     framebuffer->colors[i] = texture;
+    if(i >= framebuffer->ncolors)
+    {
+        framebuffer->ncolors = i + 1;
+    }
 
     return glbFramebufferAttachment(framebuffer, GL_COLOR_ATTACHMENT0 + i, texture);
 }
@@ -234,24 +244,19 @@ int glbFramebufferDepthStencil(GLBFramebuffer *framebuffer, GLBTexture *depth_st
 
 void glbFramebufferClear(GLBFramebuffer *framebuffer)
 {
-    if(framebuffer) 
-    { 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->globj);
-    }
+    glbStateBindFramebuffer(framebuffer ? framebuffer->globj : 0);
+    glbStateDepthWrite();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void glbFramebufferReadColor(GLBFramebuffer *framebuffer, int i, 
                              int *origin, int *region, void *dst)
 {
     if(!framebuffer) return;
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->globj);
+    glbStateBindFramebuffer(framebuffer->globj);
     glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
     glReadPixels(origin[0], origin[1], region[0], region[1], 
                  GL_RG_INTEGER, GL_UNSIGNED_SHORT, dst); //TODO: flexible format
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 GLBTexture *glbGetFramebufferColor(GLBFramebuffer *framebuffer, int i)
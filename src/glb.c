@@ -26,7 +26,7 @@
 #include <stdint.h>
 #include <string.h>
 
-#include "glb.h"
+#include "glb_private.h"
 
 #define MIN(a,b) ((a) > (b) ? (b) : (a))
 
@@ -119,6 +119,18 @@ static struct FeatureAssociation features[] =
     {"transform feedback buffer", GLB_TRANSFORM_FEEDBACK_BUFFER_FEATURE, 3, 1},
     {"uniform buffer", GLB_UNIFORM_BUFFER_FEATURE, 3, 1},
 
+    // draw features
+    {"draw base vertex", GLB_DRAW_BASE_VERTEX_FEATURE, 3, 2},
+    {"instanced arrays", GLB_INSTANCED_ARRAYS_FEATURE, 3, 3},
+    {"multi draw indirect", GLB_MULTI_DRAW_INDIRECT_FEATURE, 4, 3},
+
+    // synchronization and mapping features
+    {"map buffer range", GLB_MAP_BUFFER_RANGE_FEATURE, 3, 0},
+    {"sync", GLB_SYNC_FEATURE, 3, 2},
+    {"buffer storage", GLB_BUFFER_STORAGE_FEATURE, 4, 4},
+    {"invalidate subdata", GLB_INVALIDATE_SUBDATA_FEATURE, 4, 3},
+    {"clear buffer", GLB_CLEAR_BUFFER_FEATURE, 4, 3},
+
     // shader object features
     {"shader object", GLB_SHADER_OBJECT_FEATURE, 2, 1},
 
@@ -269,6 +281,11 @@ int glbTypeSizeof(int type)
     case GLB_UNSIGNED_INT:
         return sizeof(uint32_t);
 
+        //packed types, the size of all components
+    case GLB_INT_2_10_10_10_REV:
+    case GLB_UNSIGNED_INT_2_10_10_10_REV:
+        return sizeof(uint32_t);
+
         //vector types
     case GLB_FLOAT_VEC2:
         return sizeof(float) * 2;
@@ -385,6 +402,11 @@ bool glbTypeIsScalar(int type)
            type == GLB_HALF_FLOAT;
 }
 
+bool glbTypeIsPacked(int type)
+{
+    return type == GLB_INT_2_10_10_10_REV || type == GLB_UNSIGNED_INT_2_10_10_10_REV;
+}
+
 bool glbTypeIsVector(int type)
 {
     return glbTypeIsVec(type) || glbTypeIsIVec(type) || glbTypeIsUIVec(type) ||
@@ -556,24 +578,52 @@ struct FeatureAssociation *glbGetFeature(int feature_id)
             feature = &features[13];
             break;
 
+        // draw features
+        case GLB_DRAW_BASE_VERTEX_FEATURE:
+            feature = &features[14];
+            break;
+        case GLB_INSTANCED_ARRAYS_FEATURE:
+            feature = &features[15];
+            break;
+        case GLB_MULTI_DRAW_INDIRECT_FEATURE:
+            feature = &features[16];
+            break;
+
+        // synchronization and mapping features
+        case GLB_MAP_BUFFER_RANGE_FEATURE:
+            feature = &features[17];
+            break;
+        case GLB_SYNC_FEATURE:
+            feature = &features[18];
+            break;
+        case GLB_BUFFER_STORAGE_FEATURE:
+            feature = &features[19];
+            break;
+        case GLB_INVALIDATE_SUBDATA_FEATURE:
+            feature = &features[20];
+            break;
+        case GLB_CLEAR_BUFFER_FEATURE:
+            feature = &features[21];
+            break;
+
         // shader object features
         case GLB_SHADER_OBJECT_FEATURE:
-            feature = &features[14];
+            feature = &features[22];
             break;
         case GLB_VERTEX_SHADER_FEATURE:
-            feature = &features[15];
+            feature = &features[23];
             break;
         case GLB_TESS_CONTROL_SHADER_FEATURE:
-            feature = &features[16];
+            feature = &features[24];
             break;
         case GLB_TESS_EVALUATION_SHADER_FEATURE:
-            feature = &features[17];
+            feature = &features[25];
             break;
         case GLB_GEOMETRY_SHADER_FEATURE:
-            feature = &features[18];
+            feature = &features[26];
             break;
         case GLB_FRAGMENT_SHADER_FEATURE:
-            feature = &features[19];
+            feature = &features[27];
             break;
         default:
             feature = NULL;
@@ -583,9 +633,13 @@ struct FeatureAssociation *glbGetFeature(int feature_id)
 
 bool glbCanUseFeature(int feature_id)
 {
-    int major, minor;
-    glGetIntegerv(GL_MAJOR_VERSION, &major);
-    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    // the version is queried once, features are checked on every indirect draw
+    static int major = -1, minor = -1;
+    if(major < 0)
+    {
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+    }
     struct FeatureAssociation *feature = glbGetFeature(feature_id);
 
     return (feature && (major > feature->major ||
@@ -593,6 +647,19 @@ bool glbCanUseFeature(int feature_id)
 }
 /*}}}*/
 
+/*{{{ Object serials*/
+/**
+ * @private
+ * generates a unique, non-zero serial number. Serials are used to key caches on
+ * GLB objects without the risk of a freed object's address being reused.
+ */
+unsigned glbGenSerial(void)
+{
+    static unsigned serial = 0;
+    return ++serial;
+}
+/*}}}*/
+
 /*{{{ Error info*/
 const char *const glbErrorString(int error)
 {
@@ -618,6 +685,8 @@ const char *const glbErrorString(int error)
             return "OpenGL too old for feature";
         case GLB_SHADER_ATTACH_ERROR:
             return "error attaching shader";
+        case GLB_TIMEOUT:
+            return "timed out waiting for the GPU";
         default:
         return NULL;
     }
@@ -25,6 +25,16 @@ extern "C" {
 #include "texture.h"
 #include "shader.h"
 #include "program.h"
+#include "renderqueue.h"
+#include "commandlist.h"
+#include "mesh.h"
+#include "cull.h"
+#include "streambuffer.h"
+#include "dynamicbuffer.h"
+#include "bufferheap.h"
+#include "bufferpool.h"
+#include "readback.h"
+#include "fence.h"
 
 const char *const glbTypeString(int type);
 int glbStringType(int len, const char *const str);
@@ -35,6 +45,7 @@ bool glbTypeIsFloat(int type);
 bool glbTypeIsDouble(int type);
 bool glbTypeIsUnsigned(int type);
 bool glbTypeIsScalar(int type);
+bool glbTypeIsPacked(int type);
 bool glbTypeIsVector(int type);
 bool glbTypeIsMatrix(int type);
 bool glbTypeIsOpaque(int type);
@@ -56,21 +67,32 @@ bool glbCanUseFeature(int feature);
 // errors
 const char *const glbErrorString(int error);
 
-///TODO use draw options
+// state
+void glbInvalidateStateCache(void);
+void glbUnbindState(void);
+
+/**
+ * options set with glbProgramOption. Together they form the render state applied
+ * whenever the program draws; options that are never set are applied with their
+ * OpenGL default, overriding any raw GL call that changed them.
+ */
 enum GLBDrawOptions
 {
     GLB_NO_DRAW_OPTIONS = 0,
-    GLB_OPTIONS_RESET   = 1,
-    GLB_POLYGON_MODE    = 2,
-    GLB_CULL_MODE       = 3,
+    GLB_OPTIONS_RESET   = 1, ///< resets all options to their defaults
+    GLB_POLYGON_MODE    = 2, ///< uses enum GLBPolygonModes
+    GLB_CULL_MODE       = 3, ///< uses enum GLBCullModes
     GLB_PRIMATIVE_MODE  = 4, ///< uses enum GLBPrimativeTypes
-    GLB_FRONT_FACE_MODE = 5, // TODO: create enum
-    GLB_LINE_WIDTH      = 6,
-    GLB_POINT_SIZE      = 7,
-    GLB_PROVOKING_VERTEX = 8, // TODO: create enum
+    GLB_FRONT_FACE_MODE = 5, ///< uses enum GLBFrontFaceModes
+    GLB_LINE_WIDTH      = 6, ///< in pixels
+    GLB_POINT_SIZE      = 7, ///< in pixels
+    GLB_PROVOKING_VERTEX = 8, ///< uses enum GLBProvokingVertex
+    GLB_DEPTH_TEST      = 9,  ///< boolean, disabled by default
+    GLB_DEPTH_FUNC      = 10, ///< uses enum GLBSamplerCompareFunc
+    GLB_DEPTH_WRITE     = 11, ///< boolean, enabled by default
+    GLB_BLEND_MODE      = 12, ///< uses enum GLBBlendModes
 };
 
-///TODO use primative type option
 enum GLBPrimativeTypes
 {
     GLB_POINTS                      = GL_POINTS,
@@ -87,6 +109,41 @@ enum GLBPrimativeTypes
     GLB_PATCHES                     = GL_PATCHES,
 };
 
+enum GLBPolygonModes
+{
+    GLB_FILL    = GL_FILL,
+    GLB_LINE    = GL_LINE,
+    GLB_POINT   = GL_POINT,
+};
+
+enum GLBCullModes
+{
+    GLB_CULL_NONE           = GL_NONE,
+    GLB_CULL_FRONT          = GL_FRONT,
+    GLB_CULL_BACK           = GL_BACK,
+    GLB_CULL_FRONT_AND_BACK = GL_FRONT_AND_BACK,
+};
+
+enum GLBFrontFaceModes
+{
+    GLB_CCW = GL_CCW,
+    GLB_CW  = GL_CW,
+};
+
+enum GLBProvokingVertex
+{
+    GLB_FIRST_VERTEX = GL_FIRST_VERTEX_CONVENTION,
+    GLB_LAST_VERTEX  = GL_LAST_VERTEX_CONVENTION,
+};
+
+enum GLBBlendModes
+{
+    GLB_BLEND_NONE = 0,      ///< blending disabled
+    GLB_BLEND_ALPHA,         ///< src * src alpha + dst * (1 - src alpha)
+    GLB_BLEND_PREMULTIPLIED, ///< src + dst * (1 - src alpha)
+    GLB_BLEND_ADDITIVE,      ///< src + dst
+};
+
 enum GLBError
 {
     GLB_SUCCESS = 0, ///< guarenteed to be zero. A function completed without error
@@ -101,6 +158,7 @@ enum GLBError
     GLB_UNIMPLEMENTED, ///< a feature is currently not implemented, and may be in the future
     GLB_GL_TOO_OLD, ///< a feature depends on an OpenGL version newer than the one in use
     GLB_SHADER_ATTACH_ERROR,
+    GLB_TIMEOUT, ///< a wait for the GPU ended before the GPU was done
 };
 
 enum GLBScalar
@@ -120,6 +178,15 @@ enum GLBScalar
     GLB_UINT    = GL_UNSIGNED_INT
 };
 
+/**
+ * vertex attribute types packing all 4 components into 32 bits
+ */
+enum GLBPacked
+{
+    GLB_INT_2_10_10_10_REV          = GL_INT_2_10_10_10_REV,
+    GLB_UNSIGNED_INT_2_10_10_10_REV = GL_UNSIGNED_INT_2_10_10_10_REV,
+};
+
 enum GLBVector
 {
     GLB_VEC2    = GL_FLOAT_VEC2,
@@ -212,6 +279,18 @@ enum GLBFeatures
     GLB_TRANSFORM_FEEDBACK_BUFFER_FEATURE,
     GLB_UNIFORM_BUFFER_FEATURE,
 
+    // draw features
+    GLB_DRAW_BASE_VERTEX_FEATURE,
+    GLB_INSTANCED_ARRAYS_FEATURE,
+    GLB_MULTI_DRAW_INDIRECT_FEATURE,
+
+    // synchronization and mapping features
+    GLB_MAP_BUFFER_RANGE_FEATURE,
+    GLB_SYNC_FEATURE,
+    GLB_BUFFER_STORAGE_FEATURE,
+    GLB_INVALIDATE_SUBDATA_FEATURE,
+    GLB_CLEAR_BUFFER_FEATURE,
+
     // shader object features
     GLB_SHADER_OBJECT_FEATURE,
     GLB_VERTEX_SHADER_FEATURE = GLB_VERTEX_SHADER,
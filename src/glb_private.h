@@ -16,6 +16,7 @@
 #include "glb_types.h"
 #include "glb.h"
 #include <stdio.h>
+#include <stdint.h>
 
 #include <GL/gl.h>
 
@@ -40,10 +41,11 @@
 
 #define GLB_RETURN_ERROR(a) \
         {\
-        if(a){ \
-            printf("Error in function %s: %s\n", __FUNCTION__, glbErrorString(a));\
+        int glb_err_ = (a); /* evaluate once, 'a' is often a call */\
+        if(glb_err_){ \
+            printf("Error in function %s: %s\n", __FUNCTION__, glbErrorString(glb_err_));\
         }\
-        return (a);\
+        return glb_err_;\
         }
         
 #else
@@ -58,7 +60,33 @@
         return (a); 
 #endif
 
+unsigned glbGenSerial(void);
+
+/*{{{ State*/
+struct GLBProgramOptions;
+
+// shadowed GL bindings, see state.c
+void glbStateUseProgram(GLuint program);
+void glbStateBindVertexArray(GLuint vertexarray);
+void glbStateBindBuffer(GLenum target, GLuint buffer);
+void glbStateBindFramebuffer(GLuint framebuffer);
+void glbStateActiveTexture(int unit);
+void glbStateBindTexture(GLenum target, GLuint texture);
+void glbStateApplyOptions(const struct GLBProgramOptions *options, unsigned hash);
+void glbStateDepthWrite(void);
+
+void glbStateDeleteProgram(GLuint program);
+void glbStateDeleteVertexArray(GLuint vertexarray);
+void glbStateDeleteBuffer(GLuint buffer);
+void glbStateDeleteFramebuffer(GLuint framebuffer);
+void glbStateDeleteTexture(GLuint texture);
+/*}}}*/
+
 /*{{{ Buffer*/
+#define GLB_BUFFER_USAGE_MASK 0xffff ///< bits of 'usage' holding the GL usage
+
+
+#define GLB_MAX_VERTEX_ARRAYS 8 ///< number of vertex array objects cached per vertex buffer
 
 ///@private
 struct GLBVBufferData
@@ -75,16 +103,79 @@ struct GLBIBufferData
     int type;   ///< type of vertex indices (must be unsigned byte, short or int)
 };
 
+/**
+ * @private
+ * a cached vertex array object. Holds the attribute setup for drawing a vertex
+ * buffer with a specific program link, instance buffer and index buffer.
+ */
+struct GLBVertexArray
+{
+    GLuint globj;
+    unsigned program;  ///< serial of the program link the attributes were specified for
+    unsigned instance; ///< serial of the instance buffer, 0 if none
+    unsigned index;    ///< serial of the bound index buffer, 0 if none
+    size_t offset;         ///< offset of the vertex buffer when the attributes were specified
+    size_t instanceoffset; ///< offset of the instance buffer, 0 if none
+};
+
+/**
+ * @private
+ * bounds of consecutive runs of triangles in an index buffer, as a structure of
+ * arrays for culling. Built by glbIndexBufferClusters, all arrays share one block.
+ */
+struct GLBClusters
+{
+    int count;
+    int *first;    ///< first index of each cluster, relative to idata.offset
+    int *nindices; ///< number of indices in each cluster
+    float *x, *y, *z, *radius;    ///< bounding spheres
+    float *ax, *ay, *az, *cutoff; ///< normal cones, see glbClustersCull
+
+    // scratch space for the visible clusters and merged ranges of a culled draw
+    uint32_t *visible;
+    GLsizei *runcount;
+    const void **runfirst;
+};
+
 struct GLBBuffer
 {
     int refcount;
     GLuint globj;
+    unsigned serial; ///< unique id, never reused by another buffer
+    size_t offset;   ///< byte offset of the buffer's data in globj, non-zero for heap views
+    size_t capacity; ///< bytes of storage, more than nmemb * sz for pooled buffers
+    struct GLBBufferHeap *heap;    ///< heap the buffer is a view of, or NULL if it owns globj
+    struct GLBHeapBlock *block;    ///< the view's range in the heap
+    struct GLBBufferPool *pool;    ///< pool the buffer returns to when deleted, or NULL
+    struct GLBBuffer *poolnext;    ///< next buffer in the pool's free list
+    unsigned poolframe;            ///< pool frame the buffer was returned in
+    int usage;       ///< GL usage globj was created with, 0 if it is shared or immutable
+    int writemode;   ///< GLBWriteModes used by glbWriteBuffer
+    bool fencewrites;        ///< whether writes are fenced, set with GLB_FENCE_WRITES
+    struct GLBFence *fence;  ///< fence after the last fenced write, or NULL
 
     size_t nmemb;                ///< number of members (eg. number of vertices)
     size_t sz;                   ///< size of each member (eg. vertex size)
     struct GLBIBufferData idata; ///< index metadata (if buffer is interpreted as indices)
     struct GLBVBufferData vdata; ///< vertex metadata (if buffer is interpreted as vertices)
-};/*}}}*/
+    unsigned int *remap;         ///< new index of each vertex passed in, if welded on creation
+    size_t nremap;               ///< number of vertices passed in, if welded on creation
+    struct GLBClusters *clusters; ///< cluster bounds of the indices, or NULL
+
+    int nvertexarrays;           ///< number of cached vertex arrays
+    int nextvertexarray;         ///< next cache entry to be replaced once the cache is full
+    struct GLBVertexArray vertexarrays[GLB_MAX_VERTEX_ARRAYS];
+};
+
+void glbBufferClearVertexArrays(GLBBuffer *buffer);
+GLBBuffer *glbAllocBuffer(size_t nmemb, size_t sz);
+void glbBufferReset(GLBBuffer *buffer, size_t nmemb, size_t sz);
+GLBBuffer *glbCreateBufferStorage(size_t size, GLbitfield flags, int *errcode_ret);
+size_t glbVertexLayoutSizeof(const GLBVertexLayout *layout);
+void glbDeleteClusters(struct GLBClusters *clusters);
+int glbClustersCull(const struct GLBClusters *clusters, const float planes[6][4],
+                    const float *eye, float facing, uint32_t *visible);
+/*}}}*/
 
 /*{{{ Framebuffer*/
 struct GLBFramebuffer
@@ -94,6 +185,9 @@ struct GLBFramebuffer
 
     GLenum status; ///< current status as retrieved from glCheckFramebufferStatus
     int ncolors;    ///< number of color textures currently bound
+    unsigned version;     ///< unique id of the current attachment set
+    unsigned drawprogram; ///< serial of the program link whose draw buffers are set on the object
+    unsigned drawversion; ///< attachment set the draw buffers were set for
     GLBTexture *depth;
     GLBTexture *stencil;
     GLBTexture **colors;
@@ -154,22 +248,26 @@ struct GLBTexture
     uint32_t size;  ///< size in bytes
     GLenum target;  ///< texture unit target (eg GL_TEXTURE_2D)
     struct GLBSampler *sampler; ///< curently used sampler
+    bool fencewrites;        ///< whether writes are fenced, set with GLB_TEXTURE_FENCE_WRITES
+    struct GLBFence *fence;  ///< fence after the last fenced write, or NULL
 };/*}}}*/
 
 /*{{{ Program*/
 ///@private
-typedef struct GLBProgramOption
-{
-    int tmp;
-    //TODO: options
-} GLBProgramOption;
-
-///@private
+/// render state applied when drawing with a program, set with glbProgramOption
 typedef struct GLBProgramOptions
 {
-   int noptions;
-   int maxoptions;
-   struct GLBProgramOptions *options;
+    GLenum mode;          ///< primitive type
+    GLenum polygon;
+    GLenum cull;          ///< faces to cull, GL_NONE if culling is disabled
+    GLenum frontface;
+    GLenum provoking;
+    GLfloat linewidth;
+    GLfloat pointsize;
+    GLboolean depthtest;
+    GLboolean depthwrite;
+    GLenum depthfunc;
+    int blend;            ///< enum GLBBlendModes
 } GLBProgramOptions;
 
 ///@private
@@ -188,16 +286,171 @@ struct GLBProgram
     GLuint globj;   ///< reference to GL program object
 
     int dirty;      ///< requires a relink
+    unsigned serial; ///< unique id of the current link. Keys cached vertex arrays
     GLBShader *shaders[GLB_NPROGRAM_SHADERS]; ///< reference to attached shader
     int nuniforms;  ///< number of uniforms in all attached shaders
     int ninputs;    ///< number of inputs in all attached shaders
     int noutputs;   ///< number of ouputs in all attached shaders
     struct GLBFramebuffer *framebuffer;
-    struct GLBProgramOptions *options;
+    int ndrawbuffers;       ///< number of draw buffers in drawbuffers
+    unsigned drawversion;   ///< framebuffer attachment set drawbuffers was computed for
+    GLenum drawbuffers[GLB_MAX_OUTPUTS]; ///< color attachment written by each output
+    struct GLBProgramOptions options;
+    int optionsdirty;       ///< options changed since they were last hashed
+    unsigned optionshash;   ///< hash of options, computed when the program is cleaned
     struct GLBTexture *textures[GLB_MAX_TEXTURES]; //currently bound texture units
     struct GLBProgramIdent *uniforms[GLB_MAX_UNIFORMS];
     struct GLBProgramIdent *inputs[GLB_MAX_INPUTS];
     struct GLBProgramIdent *outputs[GLB_MAX_OUTPUTS]; //TODO use a linked list instread
 };/*}}}*/
 
+/*{{{ Render Queue*/
+struct GLBRenderQueue
+{
+    int refcount;
+
+    int nitems;         ///< number of draws collected
+    int maxitems;       ///< allocated length of each array below
+    GLBDrawItem *items; ///< draws in the order they were collected
+    GLBDrawItem *sorted; ///< draws in key order, filled on submit
+    uint64_t *keys;     ///< sort key of each draw
+    uint64_t *tmpkeys;  ///< radix sort scratch
+    uint32_t *order;    ///< item index of each key
+    uint32_t *tmporder; ///< radix sort scratch
+};/*}}}*/
+
+/*{{{ Buffer Heap*/
+#define GLB_HEAP_ALIGN 16 ///< alignment and granularity of heap views
+#define GLB_HEAP_BINS  64 ///< free list bins, one per power of two
+
+struct GLBHeapPage
+{
+    GLuint globj;
+    size_t size;
+    int index;                  ///< position in the heap's page array
+    struct GLBHeapBlock *first; ///< block at offset 0
+};
+
+/**
+ * @private
+ * a range of a heap page, either free or backing a view. Blocks of a page cover
+ * it without gaps, and two neighbouring blocks are never both free.
+ */
+struct GLBHeapBlock
+{
+    struct GLBHeapPage *page;
+    size_t offset;
+    size_t size;
+    GLBBuffer *view;                          ///< the view using the block, NULL if free
+    struct GLBHeapBlock *prev, *next;         ///< neighbouring blocks in the page
+    struct GLBHeapBlock *prevfree, *nextfree; ///< other free blocks in the same bin
+};
+
+struct GLBBufferHeap
+{
+    int refcount;
+
+    size_t pagesize; ///< size of new pages, larger allocations get a page of their own
+    int usage;       ///< GLBBufferUsage of the pages
+    int npages;
+    struct GLBHeapPage **pages;
+    struct GLBHeapBlock *bins[GLB_HEAP_BINS]; ///< free blocks, by the log2 of their size
+};
+
+void glbBufferHeapFree(GLBBufferHeap *heap, struct GLBHeapBlock *block);
+/*}}}*/
+
+/*{{{ Buffer Pool*/
+#define GLB_POOL_MIN_SIZE 256 ///< smallest size class, in bytes
+#define GLB_POOL_CLASSES  64  ///< size classes, one per power of two
+
+struct GLBBufferPool
+{
+    int refcount;
+
+    size_t maxbytes;      ///< most bytes kept in free buffers after a frame
+    unsigned maxage;      ///< frames a free buffer is kept for
+    unsigned frame;       ///< frames ended so far
+    size_t freebytes;     ///< bytes held by free buffers
+    GLBBuffer *free[GLB_POOL_CLASSES];     ///< free buffers per class, oldest first
+    GLBBuffer *freetail[GLB_POOL_CLASSES]; ///< last free buffer per class
+};
+
+void glbBufferPoolReturn(GLBBufferPool *pool, GLBBuffer *buffer);
+/*}}}*/
+
+/*{{{ Dynamic Buffer*/
+#define GLB_MAX_DYNAMIC_REGIONS 4
+#define GLB_DYNAMIC_ALIGN 256 ///< region alignment, enough to bind a region as a uniform block
+
+struct GLBDynamicBuffer
+{
+    int refcount;
+
+    GLBBuffer *buffer;    ///< the buffer drawn from, its offset is the current region's
+    size_t regionsize;    ///< bytes between regions
+    int nregions;
+    int region;           ///< region written and drawn from this frame
+    struct GLBFence *fences[GLB_MAX_DYNAMIC_REGIONS]; ///< signalled when a region's draws are done
+};/*}}}*/
+
+/*{{{ Stream Buffer*/
+#define GLB_MAX_STREAM_REGIONS 4
+
+struct GLBStreamBuffer
+{
+    int refcount;
+
+    GLBBuffer *buffer;    ///< the GL buffer allocations are made from
+    bool persistent;      ///< mapped once with buffer storage, else mapped between flushes
+    unsigned char *map;   ///< mapping starting at mapoffset, or NULL if unmapped
+    size_t mapoffset;     ///< buffer offset of the mapping, 0 if persistent
+    size_t regionsize;    ///< bytes in each region
+    int nregions;
+    int region;           ///< region allocated from during the current frame
+    size_t head;          ///< buffer offset of the next free byte in the region
+    struct GLBFence *fences[GLB_MAX_STREAM_REGIONS]; ///< signalled when a region's draws are done
+};/*}}}*/
+
+/*{{{ Fence*/
+struct GLBFence
+{
+    int refcount;
+
+    GLsync sync;     ///< the sync object, NULL once signalled or without sync objects
+    bool signaled;   ///< set once a wait has seen the fence signalled
+};
+
+void glbFenceReplace(struct GLBFence **fence);
+/*}}}*/
+
+/*{{{ Readback*/
+struct GLBReadback
+{
+    int refcount;
+
+    GLBBuffer *staging;   ///< the copy of the range read back
+    struct GLBFence *fence; ///< signalled when the copy is done
+    const void *map;      ///< read mapping of the staging buffer, or NULL if unmapped
+};/*}}}*/
+
+/*{{{ Command List*/
+struct GLBCommand;
+struct GLBCommandChunk;
+
+struct GLBCommandList
+{
+    int refcount;
+
+    struct GLBCommandChunk *chunks; ///< all chunks owned by the list
+    struct GLBCommandChunk *chunk;  ///< chunk currently allocated from
+    struct GLBCommand *first;       ///< first recorded command
+    struct GLBCommand *last;        ///< last recorded command
+    int ncommands;
+
+    int ndraws;         ///< consecutive draws gathered during execution
+    int maxdraws;       ///< allocated length of draws
+    GLBDrawItem *draws; ///< draws submitted together as one batch
+};/*}}}*/
+
 #endif
@@ -18,20 +18,49 @@ struct GLBVertexLayout
     unsigned int normalized;
     unsigned int stride;
     unsigned int offset;
+    unsigned int divisor; ///< 0 if per vertex, else the number of instances per element
 };
 
+struct GLBBounds;
 struct GLBBuffer;
+struct GLBBufferHeap;
+struct GLBBufferPool;
+struct GLBCommandList;
+struct GLBDrawItem;
+struct GLBDynamicBuffer;
+struct GLBDrawIndirectCommand;
+struct GLBDrawIndexedIndirectCommand;
+struct GLBDrawTexture;
+struct GLBDrawUniform;
+struct GLBFence;
 struct GLBFramebuffer;
 struct GLBProgram;
+struct GLBReadback;
+struct GLBRenderQueue;
 struct GLBSampler;
 struct GLBShader;
+struct GLBStreamBuffer;
 struct GLBTexture;
 
+typedef struct GLBBounds GLBBounds;
 typedef struct GLBBuffer GLBBuffer;
+typedef struct GLBBufferHeap GLBBufferHeap;
+typedef struct GLBBufferPool GLBBufferPool;
+typedef struct GLBCommandList GLBCommandList;
+typedef struct GLBDrawItem GLBDrawItem;
+typedef struct GLBDynamicBuffer GLBDynamicBuffer;
+typedef struct GLBDrawIndirectCommand GLBDrawIndirectCommand;
+typedef struct GLBDrawIndexedIndirectCommand GLBDrawIndexedIndirectCommand;
+typedef struct GLBDrawTexture GLBDrawTexture;
+typedef struct GLBDrawUniform GLBDrawUniform;
+typedef struct GLBFence GLBFence;
 typedef struct GLBFramebuffer GLBFramebuffer;
 typedef struct GLBProgram GLBProgram;
+typedef struct GLBReadback GLBReadback;
+typedef struct GLBRenderQueue GLBRenderQueue;
 typedef struct GLBSampler GLBSampler;
 typedef struct GLBShader GLBShader;
+typedef struct GLBStreamBuffer GLBStreamBuffer;
 typedef struct GLBTexture GLBTexture;
 typedef struct GLBVertexLayout GLBVertexLayout;
 
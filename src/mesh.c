@@ -0,0 +1,1202 @@
+/**
+ * mesh.c
+ * @file mesh.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief mesh optimizations for index and vertex buffers
+ *
+ * glbOptimizeIndices reorders the triangles of an indexed triangle list so that
+ * vertices are reused while they are still in the post-transform vertex cache,
+ * using Tom Forsyth's "Linear-Speed Vertex Cache Optimisation". Each vertex is
+ * scored by its position in a modelled LRU cache and by the number of triangles
+ * still using it; the triangle with the best score is emitted next.
+ *
+ * glbOptimizeVertexFetch then reorders the vertices to the order they are first
+ * used in, so vertex fetches walk through memory sequentially.
+ *
+ * glbWeldVertices merges vertices whose attributes are bit-identical, producing
+ * a remap table that glbRemapIndices applies to the indices referencing them.
+ *
+ * glbQuantizeVertices converts float attributes to half floats, normalized shorts,
+ * normalized bytes or packed 10_10_10_2 values. Each attribute is gathered into a
+ * flat array and converted 4 to 16 values at a time with SSE2, or F16C for half
+ * floats, when the compiler targets them.
+ *
+ * The buffer variants read the buffers back, optimize them on the CPU and write
+ * them again, so they are meant for load time.
+ */
+
+#include "glb_private.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+#define GLB_VCACHE_SIZE         32  ///< modelled post-transform cache size
+#define GLB_VCACHE_MAX_VALENCE  32  ///< valences above this share a score
+
+#define GLB_VCACHE_DECAY_POWER    1.5f
+#define GLB_VCACHE_LAST_TRI_SCORE 0.75f
+#define GLB_VALENCE_BOOST_SCALE   2.0f
+#define GLB_VALENCE_BOOST_POWER   0.5f
+
+/*{{{ Scoring*/
+///@private
+struct GLBVertexScores
+{
+    float cache[GLB_VCACHE_SIZE];
+    float valence[GLB_VCACHE_MAX_VALENCE];
+};
+
+static void glbInitVertexScores(struct GLBVertexScores *scores)
+{
+    int i;
+    for(i = 0; i < GLB_VCACHE_SIZE; i++)
+    {
+        if(i < 3)
+        {
+            // the last triangle's vertices score the same, whatever their order
+            scores->cache[i] = GLB_VCACHE_LAST_TRI_SCORE;
+        } else
+        {
+            float scale = 1.0f / (GLB_VCACHE_SIZE - 3);
+            scores->cache[i] = powf(1.0f - (i - 3) * scale, GLB_VCACHE_DECAY_POWER);
+        }
+    }
+
+    scores->valence[0] = 0.0f;
+    for(i = 1; i < GLB_VCACHE_MAX_VALENCE; i++)
+    {
+        scores->valence[i] = GLB_VALENCE_BOOST_SCALE * powf(i, -GLB_VALENCE_BOOST_POWER);
+    }
+}
+
+/**
+ * @param cachepos position of the vertex in the cache, -1 if it is not cached
+ * @param valence number of triangles not yet emitted that use the vertex
+ */
+static float glbVertexScore(const struct GLBVertexScores *scores, int cachepos, int valence)
+{
+    if(!valence)
+    {
+        return -1.0f; // no triangles left to draw with this vertex
+    }
+
+    float score = cachepos >= 0 ? scores->cache[cachepos] : 0.0f;
+    return score + scores->valence[valence < GLB_VCACHE_MAX_VALENCE ?
+                                   valence : GLB_VCACHE_MAX_VALENCE - 1];
+}/*}}}*/
+
+/*{{{ Arrays*/
+/**
+ * reorders the triangles of an indexed triangle list for the post-transform
+ * vertex cache. The triangles are kept intact, only their order changes.
+ * @param indices the triangle list, rewritten in place
+ * @param nindices number of indices, a multiple of 3
+ * @param nverts number of vertices referenced, every index must be less than this
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if the list is malformed, or
+ * GLB_OUT_OF_MEMORY
+ */
+int glbOptimizeIndices(unsigned int *indices, size_t nindices, size_t nverts)
+{
+    int errcode = GLB_SUCCESS;
+    size_t i, j, k;
+    size_t ntris = nindices / 3;
+    GLB_ASSERT(indices || !nindices, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(nindices % 3 == 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    for(i = 0; i < nindices; i++)
+    {
+        GLB_ASSERT(indices[i] < nverts, GLB_INVALID_ARGUMENT, ERROR);
+    }
+
+    if(ntris < 2)
+    {
+        return GLB_SUCCESS;
+    }
+
+    struct GLBVertexScores scores;
+    glbInitVertexScores(&scores);
+
+    int *valence = calloc(nverts, sizeof(int));          // triangles left per vertex
+    int *cachepos = malloc(nverts * sizeof(int));
+    float *vscore = malloc(nverts * sizeof(float));
+    size_t *adjstart = malloc(nverts * sizeof(size_t));   // first triangle of each vertex
+    unsigned int *adjacency = malloc(nindices * sizeof(unsigned int));
+    float *tscore = malloc(ntris * sizeof(float));
+    bool *emitted = calloc(ntris, sizeof(bool));
+    unsigned int *out = malloc(nindices * sizeof(unsigned int));
+
+    if(!valence || !cachepos || !vscore || !adjstart ||
+       !adjacency || !tscore || !emitted || !out)
+    {
+        errcode = GLB_OUT_OF_MEMORY;
+        goto CLEANUP;
+    }
+
+    // triangles using each vertex
+    for(i = 0; i < nindices; i++)
+    {
+        valence[indices[i]]++;
+    }
+
+    size_t sum = 0;
+    for(i = 0; i < nverts; i++)
+    {
+        adjstart[i] = sum;
+        sum += valence[i];
+        valence[i] = 0;
+    }
+
+    for(i = 0; i < nindices; i++)
+    {
+        unsigned int v = indices[i];
+        adjacency[adjstart[v] + valence[v]++] = i / 3;
+    }
+
+    for(i = 0; i < nverts; i++)
+    {
+        cachepos[i] = -1;
+        vscore[i] = glbVertexScore(&scores, -1, valence[i]);
+    }
+
+    long best = 0;
+    for(i = 0; i < ntris; i++)
+    {
+        const unsigned int *tri = &indices[i * 3];
+        tscore[i] = vscore[tri[0]] + vscore[tri[1]] + vscore[tri[2]];
+        if(tscore[i] > tscore[best])
+        {
+            best = i;
+        }
+    }
+
+    unsigned int cache[GLB_VCACHE_SIZE + 3];
+    int ncache = 0;
+    size_t cursor = 0;
+
+    for(i = 0; i < ntris; i++)
+    {
+        if(best < 0)
+        {
+            // nothing in the cache has triangles left, start from a new triangle
+            while(emitted[cursor])
+            {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const unsigned int *tri = &indices[best * 3];
+        memcpy(&out[i * 3], tri, 3 * sizeof(unsigned int));
+        emitted[best] = true;
+
+        // remove the triangle from its vertices' lists
+        for(k = 0; k < 3; k++)
+        {
+            unsigned int v = tri[k];
+            unsigned int *adj = &adjacency[adjstart[v]];
+            for(j = 0; j < (size_t) valence[v]; j++)
+            {
+                if(adj[j] == (unsigned int) best)
+                {
+                    adj[j] = adj[--valence[v]];
+                    break;
+                }
+            }
+        }
+
+        // move the triangle's vertices to the front of the cache
+        unsigned int newcache[GLB_VCACHE_SIZE + 3];
+        int nnew = 0;
+        for(k = 0; k < 3; k++)
+        {
+            if((k < 1 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1]))
+            {
+                newcache[nnew++] = tri[k];
+            }
+        }
+
+        for(j = 0; j < (size_t) ncache; j++)
+        {
+            unsigned int v = cache[j];
+            if(v != tri[0] && v != tri[1] && v != tri[2])
+            {
+                newcache[nnew++] = v;
+            }
+        }
+
+        // rescore the cached vertices, and the ones that just fell out
+        for(j = 0; j < (size_t) nnew; j++)
+        {
+            unsigned int v = newcache[j];
+            cachepos[v] = j < GLB_VCACHE_SIZE ? (int) j : -1;
+            vscore[v] = glbVertexScore(&scores, cachepos[v], valence[v]);
+        }
+
+        // rescore their triangles, the best of which is emitted next
+        best = -1;
+        for(j = 0; j < (size_t) nnew; j++)
+        {
+            unsigned int v = newcache[j];
+            unsigned int *adj = &adjacency[adjstart[v]];
+            for(k = 0; k < (size_t) valence[v]; k++)
+            {
+                unsigned int t = adj[k];
+                const unsigned int *ttri = &indices[t * 3];
+                tscore[t] = vscore[ttri[0]] + vscore[ttri[1]] + vscore[ttri[2]];
+                if(best < 0 || tscore[t] > tscore[best])
+                {
+                    best = t;
+                }
+            }
+        }
+
+        ncache = nnew < GLB_VCACHE_SIZE ? nnew : GLB_VCACHE_SIZE;
+        memcpy(cache, newcache, ncache * sizeof(unsigned int));
+    }
+
+    memcpy(indices, out, nindices * sizeof(unsigned int));
+
+CLEANUP:
+    free(valence);
+    free(cachepos);
+    free(vscore);
+    free(adjstart);
+    free(adjacency);
+    free(tscore);
+    free(emitted);
+    free(out);
+    GLB_RETURN_ERROR(errcode);
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * reorders vertices to the order in which the indices first use them, and
+ * rewrites the indices to match. Vertices that are not referenced are moved to
+ * the end, keeping their relative order. Best run after glbOptimizeIndices.
+ * @param vertices 'nverts' vertices of 'sz' bytes each, rewritten in place
+ * @param indices the indices referencing the vertices, rewritten in place
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if an index is out of range, or
+ * GLB_OUT_OF_MEMORY
+ */
+int glbOptimizeVertexFetch(void *vertices, size_t sz, size_t nverts,
+                           unsigned int *indices, size_t nindices)
+{
+    int errcode = GLB_SUCCESS;
+    size_t i;
+    GLB_ASSERT(vertices && sz && (indices || !nindices), GLB_INVALID_ARGUMENT, ERROR);
+
+    for(i = 0; i < nindices; i++)
+    {
+        GLB_ASSERT(indices[i] < nverts, GLB_INVALID_ARGUMENT, ERROR);
+    }
+
+    unsigned int *remap = malloc(nverts * sizeof(unsigned int));
+    unsigned char *tmp = malloc(nverts * sz);
+    if(!remap || !tmp)
+    {
+        errcode = GLB_OUT_OF_MEMORY;
+        goto CLEANUP;
+    }
+
+    memset(remap, 0xff, nverts * sizeof(unsigned int));
+    unsigned int next = 0;
+    for(i = 0; i < nindices; i++)
+    {
+        unsigned int v = indices[i];
+        if(remap[v] == (unsigned int) -1)
+        {
+            remap[v] = next++;
+        }
+        indices[i] = remap[v];
+    }
+
+    for(i = 0; i < nverts; i++)
+    {
+        if(remap[i] == (unsigned int) -1)
+        {
+            remap[i] = next++;
+        }
+        memcpy(&tmp[remap[i] * sz], (unsigned char*) vertices + i * sz, sz);
+    }
+
+    memcpy(vertices, tmp, nverts * sz);
+
+CLEANUP:
+    free(remap);
+    free(tmp);
+    GLB_RETURN_ERROR(errcode);
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}/*}}}*/
+
+/*{{{ Welding*/
+/**
+ * checks that every attribute of 'desc' lies within a vertex of 'sz' bytes,
+ * as in an interleaved buffer.
+ */
+static bool glbLayoutInterleaved(size_t sz, int ndesc, const GLBVertexLayout *desc)
+{
+    int i;
+    for(i = 0; i < ndesc; i++)
+    {
+        size_t asz = glbVertexLayoutSizeof(&desc[i]);
+        size_t stride = desc[i].stride ? desc[i].stride : asz;
+        if(!asz || stride != sz || desc[i].offset + asz > sz)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t glbHashVertex(const unsigned char *vertex, size_t sz,
+                              int ndesc, const GLBVertexLayout *desc)
+{
+    int i;
+    size_t j;
+    uint64_t hash = UINT64_C(14695981039346656037);
+    if(!ndesc)
+    {
+        for(j = 0; j < sz; j++)
+        {
+            hash = (hash ^ vertex[j]) * UINT64_C(1099511628211);
+        }
+        return hash;
+    }
+
+    for(i = 0; i < ndesc; i++)
+    {
+        const unsigned char *attrib = vertex + desc[i].offset;
+        size_t asz = glbVertexLayoutSizeof(&desc[i]);
+        for(j = 0; j < asz; j++)
+        {
+            hash = (hash ^ attrib[j]) * UINT64_C(1099511628211);
+        }
+    }
+    return hash;
+}
+
+static bool glbVertexEqual(const unsigned char *a, const unsigned char *b, size_t sz,
+                           int ndesc, const GLBVertexLayout *desc)
+{
+    int i;
+    if(!ndesc)
+    {
+        return !memcmp(a, b, sz);
+    }
+
+    for(i = 0; i < ndesc; i++)
+    {
+        size_t asz = glbVertexLayoutSizeof(&desc[i]);
+        if(memcmp(a + desc[i].offset, b + desc[i].offset, asz))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * merges vertices whose attributes are bit-identical. Only the bytes covered by
+ * the layout are compared, so padding between attributes does not prevent a
+ * merge. Unique vertices are moved to the front, in the order they first appear.
+ * @param vertices 'nverts' interleaved vertices of 'sz' bytes, rewritten in place
+ * @param ndesc number of attributes in 'desc', or 0 to compare whole vertices
+ * @param desc the vertex layout. Every attribute must lie within the vertex.
+ * @param remap filled with the new index of each of the 'nverts' original vertices
+ * @param nunique returns the number of vertices left
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if the layout is not interleaved,
+ * or GLB_OUT_OF_MEMORY
+ */
+int glbWeldVertices(void *vertices, size_t sz, size_t nverts,
+                    int ndesc, const GLBVertexLayout *desc,
+                    unsigned int *remap, size_t *nunique)
+{
+    int errcode;
+    size_t i;
+    GLB_ASSERT(vertices && sz && remap && nunique, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(!ndesc || (desc && glbLayoutInterleaved(sz, ndesc, desc)),
+               GLB_INVALID_ARGUMENT, ERROR);
+
+    // open addressing, at most half full
+    size_t size = 16;
+    while(size < nverts * 2)
+    {
+        size *= 2;
+    }
+
+    unsigned int *table = malloc(size * sizeof(unsigned int));
+    GLB_ASSERT(table, GLB_OUT_OF_MEMORY, ERROR);
+    memset(table, 0xff, size * sizeof(unsigned int));
+
+    unsigned char *data = vertices;
+    size_t n = 0;
+    for(i = 0; i < nverts; i++)
+    {
+        const unsigned char *vertex = data + i * sz;
+        size_t slot = glbHashVertex(vertex, sz, ndesc, desc) & (size - 1);
+
+        while(table[slot] != (unsigned int) -1 &&
+              !glbVertexEqual(data + table[slot] * sz, vertex, sz, ndesc, desc))
+        {
+            slot = (slot + 1) & (size - 1);
+        }
+
+        if(table[slot] == (unsigned int) -1)
+        {
+            // unique vertices are only ever moved towards the front, over ones already read
+            if(n != i)
+            {
+                memcpy(data + n * sz, vertex, sz);
+            }
+            table[slot] = n++;
+        }
+        remap[i] = table[slot];
+    }
+
+    free(table);
+    *nunique = n;
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * rewrites each index through a remap table, such as one from glbWeldVertices.
+ * @param nremap number of entries in 'remap'. Every index must be less than this.
+ */
+int glbRemapIndices(unsigned int *indices, size_t nindices,
+                    const unsigned int *remap, size_t nremap)
+{
+    int errcode;
+    size_t i;
+    GLB_ASSERT((indices || !nindices) && remap, GLB_INVALID_ARGUMENT, ERROR);
+
+    for(i = 0; i < nindices; i++)
+    {
+        GLB_ASSERT(indices[i] < nremap, GLB_INVALID_ARGUMENT, ERROR);
+    }
+
+    for(i = 0; i < nindices; i++)
+    {
+        indices[i] = remap[indices[i]];
+    }
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}/*}}}*/
+
+/*{{{ Quantization*/
+/**
+ * rounds a float to the nearest half float, ties to even. Values too large for a
+ * half become infinity and NaNs stay NaNs.
+ */
+static uint16_t glbFloatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(uint32_t));
+    uint16_t sign = (x >> 16) & 0x8000;
+    x &= 0x7fffffff;
+
+    if(x >= 0x47800000) // 65536 and above, infinity or NaN
+    {
+        return sign | (x > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+
+    if(x < 0x38800000) // half denormals and zero
+    {
+        // adding 0.5 lines the half's mantissa up with the float's, and rounds it
+        float d;
+        memcpy(&d, &x, sizeof(float));
+        d += 0.5f;
+        memcpy(&x, &d, sizeof(uint32_t));
+        return sign | (uint16_t) (x - 0x3f000000);
+    }
+
+    // rebias the exponent and round the mantissa, carrying into the exponent
+    uint32_t odd = (x >> 13) & 1;
+    x += ((uint32_t) (15 - 127) << 23) + 0xfff + odd;
+    return sign | (uint16_t) (x >> 13);
+}
+
+static void glbQuantizeHalf(const float *src, uint16_t *dst, size_t n)
+{
+    size_t i = 0;
+#ifdef __F16C__
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i h = _mm_cvtps_ph(_mm_loadu_ps(&src[i]), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storel_epi64((__m128i*) &dst[i], h);
+    }
+#endif
+    for(; i < n; i++)
+    {
+        dst[i] = glbFloatToHalf(src[i]);
+    }
+}
+
+static void glbQuantizeSnorm16(const float *src, int16_t *dst, size_t n)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    for(; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i]), lo), hi);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i + 4]), lo), hi);
+        __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+        __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+        _mm_storeu_si128((__m128i*) &dst[i], _mm_packs_epi32(ia, ib));
+    }
+#endif
+    for(; i < n; i++)
+    {
+        dst[i] = (int16_t) lrintf(fminf(fmaxf(src[i], -1.0f), 1.0f) * 32767.0f);
+    }
+}
+
+static void glbQuantizeUnorm8(const float *src, uint8_t *dst, size_t n)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 lo = _mm_setzero_ps();
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i v[4];
+        int j;
+        for(j = 0; j < 4; j++)
+        {
+            __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&src[i + j * 4]), lo), hi);
+            v[j] = _mm_cvtps_epi32(_mm_mul_ps(f, scale));
+        }
+        __m128i a = _mm_packs_epi32(v[0], v[1]);
+        __m128i b = _mm_packs_epi32(v[2], v[3]);
+        _mm_storeu_si128((__m128i*) &dst[i], _mm_packus_epi16(a, b));
+    }
+#endif
+    for(; i < n; i++)
+    {
+        dst[i] = (uint8_t) lrintf(fminf(fmaxf(src[i], 0.0f), 1.0f) * 255.0f);
+    }
+}
+
+/**
+ * packs 4 floats per element into signed normalized 10_10_10_2 values, as read
+ * by GL_INT_2_10_10_10_REV. w only has the values -1, 0 and 1.
+ */
+static void glbQuantizeSnorm10(const float *src, uint32_t *dst, size_t n)
+{
+    size_t i;
+    int32_t c[4];
+    for(i = 0; i < n; i++)
+    {
+        const float *f = &src[i * 4];
+#ifdef __SSE2__
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(f), _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        v = _mm_mul_ps(v, _mm_setr_ps(511.0f, 511.0f, 511.0f, 1.0f));
+        _mm_storeu_si128((__m128i*) c, _mm_cvtps_epi32(v));
+#else
+        int j;
+        for(j = 0; j < 4; j++)
+        {
+            c[j] = lrintf(fminf(fmaxf(f[j], -1.0f), 1.0f) * (j < 3 ? 511.0f : 1.0f));
+        }
+#endif
+        dst[i] = ((uint32_t) c[0] & 0x3ff) |
+                 (((uint32_t) c[1] & 0x3ff) << 10) |
+                 (((uint32_t) c[2] & 0x3ff) << 20) |
+                 (((uint32_t) c[3] & 0x3) << 30);
+    }
+}
+
+/**
+ * computes the layout of quantized vertices, with each attribute aligned to 4 bytes.
+ */
+static int glbQuantizeLayout(int ndesc, const GLBVertexLayout *desc, const int *precision,
+                             GLBVertexLayout *dstdesc, size_t *dstsz)
+{
+    int i;
+    size_t offset = 0;
+    for(i = 0; i < ndesc; i++)
+    {
+        GLBVertexLayout layout = desc[i];
+        if(precision[i] != GLB_PRECISION_KEEP &&
+           (layout.type != GLB_FLOAT || layout.size < 1 || layout.size > 4))
+        {
+            return GLB_INVALID_ARGUMENT;
+        }
+
+        switch(precision[i])
+        {
+            case GLB_PRECISION_KEEP:
+                break;
+            case GLB_PRECISION_HALF:
+                layout.type = GLB_HALF_FLOAT;
+                layout.normalized = false;
+                break;
+            case GLB_PRECISION_SNORM16:
+                layout.type = GLB_SHORT;
+                layout.normalized = true;
+                break;
+            case GLB_PRECISION_UNORM8:
+                layout.type = GLB_UNSIGNED_BYTE;
+                layout.normalized = true;
+                break;
+            case GLB_PRECISION_SNORM10:
+                layout.type = GLB_INT_2_10_10_10_REV;
+                layout.size = 4;
+                layout.normalized = true;
+                break;
+            default:
+                return GLB_INVALID_ARGUMENT;
+        }
+
+        layout.offset = offset;
+        offset += (glbVertexLayoutSizeof(&layout) + 3) & ~(size_t) 3;
+        dstdesc[i] = layout;
+    }
+
+    for(i = 0; i < ndesc; i++)
+    {
+        dstdesc[i].stride = offset;
+    }
+    *dstsz = offset;
+    return GLB_SUCCESS;
+}
+
+/**
+ * converts float vertex attributes to lower precision types, interleaving the
+ * result. Each attribute is read at its offset plus its stride times the vertex
+ * index, so 'src' may be interleaved or hold one array per attribute.
+ * @param src vertices described by 'desc'
+ * @param precision a GLBVertexPrecision per attribute. Attributes not kept must be
+ * GLB_FLOAT with 1 to 4 components. 3 or fewer components quantized to
+ * GLB_PRECISION_SNORM10 are padded with 0, and w with 1, as GL does.
+ * @param dst receives 'nverts' vertices of '*dstsz' bytes, or NULL to only compute
+ * the layout
+ * @param dstdesc receives the layout of the quantized vertices, 'ndesc' entries
+ * @param dstsz returns the size of a quantized vertex
+ * @returns 0 on success, GLB_INVALID_ARGUMENT, or GLB_OUT_OF_MEMORY
+ */
+int glbQuantizeVertices(const void *src, size_t nverts, int ndesc, const GLBVertexLayout *desc,
+                        const int *precision, void *dst,
+                        GLBVertexLayout *dstdesc, size_t *dstsz)
+{
+    int errcode;
+    int i;
+    size_t v, j;
+    float *flat = NULL;
+    void *packed = NULL;
+    GLB_ASSERT(ndesc > 0 && desc && precision && dstdesc && dstsz, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(src || !dst, GLB_INVALID_ARGUMENT, ERROR);
+
+    errcode = glbQuantizeLayout(ndesc, desc, precision, dstdesc, dstsz);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    if(!dst || !nverts)
+    {
+        return GLB_SUCCESS;
+    }
+
+    const unsigned char *in = src;
+    unsigned char *out = dst;
+    size_t sz = *dstsz;
+    memset(out, 0, nverts * sz);
+
+    flat = malloc(nverts * 4 * sizeof(float));
+    packed = malloc(nverts * 4 * sizeof(float));
+    GLB_ASSERT(flat && packed, GLB_OUT_OF_MEMORY, ERROR);
+
+    for(i = 0; i < ndesc; i++)
+    {
+        size_t insz = glbVertexLayoutSizeof(&desc[i]);
+        size_t instride = desc[i].stride ? desc[i].stride : insz;
+        size_t outsz = glbVertexLayoutSizeof(&dstdesc[i]);
+        const unsigned char *from = in + desc[i].offset;
+        const unsigned char *to = packed;
+
+        if(precision[i] == GLB_PRECISION_KEEP)
+        {
+            for(v = 0; v < nverts; v++)
+            {
+                memcpy(out + v * sz + dstdesc[i].offset, from + v * instride, insz);
+            }
+            continue;
+        }
+
+        // gather the components into a flat array, padded to xyzw for packing
+        size_t ncomp = precision[i] == GLB_PRECISION_SNORM10 ? 4 : desc[i].size;
+        for(v = 0; v < nverts; v++)
+        {
+            float *f = &flat[v * ncomp];
+            memcpy(f, from + v * instride, insz);
+            for(j = desc[i].size; j < ncomp; j++)
+            {
+                f[j] = j == 3 ? 1.0f : 0.0f;
+            }
+        }
+
+        switch(precision[i])
+        {
+            case GLB_PRECISION_HALF:
+                glbQuantizeHalf(flat, packed, nverts * ncomp);
+                break;
+            case GLB_PRECISION_SNORM16:
+                glbQuantizeSnorm16(flat, packed, nverts * ncomp);
+                break;
+            case GLB_PRECISION_UNORM8:
+                glbQuantizeUnorm8(flat, packed, nverts * ncomp);
+                break;
+            case GLB_PRECISION_SNORM10:
+                glbQuantizeSnorm10(flat, packed, nverts);
+                break;
+        }
+
+        for(v = 0; v < nverts; v++)
+        {
+            memcpy(out + v * sz + dstdesc[i].offset, to + v * outsz, outsz);
+        }
+    }
+
+    free(flat);
+    free(packed);
+    return GLB_SUCCESS;
+
+ERROR:
+    free(flat);
+    free(packed);
+    GLB_RETURN_ERROR(errcode);
+}/*}}}*/
+
+/*{{{ Buffers*/
+/**
+ * reads the indices described by the buffer's index format, widened to
+ * unsigned int. The result must be freed.
+ */
+static unsigned int *glbReadIndices(GLBBuffer *index)
+{
+    size_t i;
+    size_t n = index->idata.count;
+    int isz = glbTypeSizeof(index->idata.type);
+    unsigned int *indices = malloc(n * sizeof(unsigned int));
+    if(!indices) return NULL;
+
+    glbReadBuffer(index, (size_t) index->idata.offset * isz, n * isz, indices);
+
+    // widen in place, from the back so nothing is overwritten before it is read
+    if(isz == sizeof(uint16_t))
+    {
+        const uint16_t *src = (const uint16_t*) indices;
+        for(i = n; i-- > 0;)
+        {
+            indices[i] = src[i];
+        }
+    } else if(isz == sizeof(uint8_t))
+    {
+        const uint8_t *src = (const uint8_t*) indices;
+        for(i = n; i-- > 0;)
+        {
+            indices[i] = src[i];
+        }
+    }
+    return indices;
+}
+
+/**
+ * writes indices back in the buffer's index type. 'indices' is overwritten.
+ */
+static void glbWriteIndices(GLBBuffer *index, unsigned int *indices)
+{
+    size_t i;
+    size_t n = index->idata.count;
+    int isz = glbTypeSizeof(index->idata.type);
+
+    if(isz == sizeof(uint16_t))
+    {
+        uint16_t *dst = (uint16_t*) indices;
+        for(i = 0; i < n; i++)
+        {
+            dst[i] = indices[i];
+        }
+    } else if(isz == sizeof(uint8_t))
+    {
+        uint8_t *dst = (uint8_t*) indices;
+        for(i = 0; i < n; i++)
+        {
+            dst[i] = indices[i];
+        }
+    }
+
+    glbWriteBuffer(index, (size_t) index->idata.offset * isz, n * isz, indices);
+}
+
+/**
+ * reorders the triangles of an index buffer for the post-transform vertex cache,
+ * as glbOptimizeIndices. The indices described by the buffer's index format are
+ * read back, optimized and written again.
+ * @param nverts number of vertices the indices reference
+ */
+int glbOptimizeIndexBuffer(GLBBuffer *index, int nverts)
+{
+    int errcode;
+    GLB_ASSERT(index && nverts >= 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    unsigned int *indices = glbReadIndices(index);
+    GLB_ASSERT(indices, GLB_OUT_OF_MEMORY, ERROR);
+
+    errcode = glbOptimizeIndices(indices, index->idata.count, nverts);
+    if(!errcode)
+    {
+        glbWriteIndices(index, indices);
+    }
+    free(indices);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * reorders the vertices of 'array' to the order 'index' first uses them, as
+ * glbOptimizeVertexFetch, and rewrites 'index' to match. Should follow
+ * glbOptimizeIndexBuffer. Any other index buffer using 'array' will no longer
+ * reference the right vertices.
+ */
+int glbOptimizeVertexBuffer(GLBBuffer *array, GLBBuffer *index)
+{
+    int errcode;
+    GLB_ASSERT(array && index && array->sz, GLB_INVALID_ARGUMENT, ERROR);
+
+    unsigned int *indices = glbReadIndices(index);
+    void *vertices = malloc(array->nmemb * array->sz);
+    if(!indices || !vertices)
+    {
+        free(indices);
+        free(vertices);
+        GLB_ASSERT(0, GLB_OUT_OF_MEMORY, ERROR);
+    }
+
+    glbReadBuffer(array, 0, array->nmemb * array->sz, vertices);
+    errcode = glbOptimizeVertexFetch(vertices, array->sz, array->nmemb,
+                                     indices, index->idata.count);
+    if(!errcode)
+    {
+        glbWriteBuffer(array, 0, array->nmemb * array->sz, vertices);
+        glbWriteIndices(index, indices);
+    }
+
+    free(indices);
+    free(vertices);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * rewrites 'index' to reference the vertices of 'array' after 'array' was welded
+ * on creation, see GLB_WELD_VERTICES. The indices described by the buffer's
+ * index format are read back, remapped and written again.
+ * @returns 0 on success, GLB_INVALID_ARGUMENT if 'array' has no remap table or an
+ * index is out of range, or GLB_OUT_OF_MEMORY
+ */
+int glbRemapIndexBuffer(GLBBuffer *index, GLBBuffer *array)
+{
+    int errcode;
+    GLB_ASSERT(index && array && array->remap, GLB_INVALID_ARGUMENT, ERROR);
+
+    unsigned int *indices = glbReadIndices(index);
+    GLB_ASSERT(indices, GLB_OUT_OF_MEMORY, ERROR);
+
+    errcode = glbRemapIndices(indices, index->idata.count, array->remap, array->nremap);
+    if(!errcode)
+    {
+        glbWriteIndices(index, indices);
+    }
+    free(indices);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}/*}}}*/
+
+/*{{{ Clusters*/
+static struct GLBClusters *glbCreateClusters(int count)
+{
+    // pointers first, so every array in the block is aligned
+    size_t sz = sizeof(struct GLBClusters) +
+                count * (sizeof(void*) + sizeof(GLsizei) + 3 * sizeof(int) + 8 * sizeof(float));
+    struct GLBClusters *clusters = malloc(sz);
+    if(!clusters) return NULL;
+
+    clusters->count = count;
+    clusters->runfirst = (const void**) (clusters + 1);
+    float *f = (float*) (clusters->runfirst + count);
+    clusters->x = f;
+    clusters->y = f + count;
+    clusters->z = f + count * 2;
+    clusters->radius = f + count * 3;
+    clusters->ax = f + count * 4;
+    clusters->ay = f + count * 5;
+    clusters->az = f + count * 6;
+    clusters->cutoff = f + count * 7;
+    clusters->first = (int*) (f + count * 8);
+    clusters->nindices = clusters->first + count;
+    clusters->visible = (uint32_t*) (clusters->nindices + count);
+    clusters->runcount = (GLsizei*) (clusters->visible + count);
+    return clusters;
+}
+
+/**
+ * @private
+ */
+void glbDeleteClusters(struct GLBClusters *clusters)
+{
+    free(clusters);
+}
+
+/**
+ * computes the bounding sphere and normal cone of the triangles in 'indices'.
+ * The cone holds every face normal; a cluster is back facing from any point
+ * where dot(center - eye, axis) >= cutoff * |center - eye| + radius.
+ */
+static void glbClusterBounds(struct GLBClusters *clusters, int c, const unsigned char *vertices,
+                             size_t stride, const unsigned int *indices, int n)
+{
+    int i, j;
+    float lo[3] = {INFINITY, INFINITY, INFINITY};
+    float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for(i = 0; i < n; i++)
+    {
+        const float *p = (const float*) (vertices + indices[i] * stride);
+        for(j = 0; j < 3; j++)
+        {
+            lo[j] = fminf(lo[j], p[j]);
+            hi[j] = fmaxf(hi[j], p[j]);
+        }
+    }
+
+    float center[3];
+    for(j = 0; j < 3; j++)
+    {
+        center[j] = (lo[j] + hi[j]) * 0.5f;
+    }
+
+    float radius = 0.0f;
+    for(i = 0; i < n; i++)
+    {
+        const float *p = (const float*) (vertices + indices[i] * stride);
+        float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+        radius = fmaxf(radius, dx * dx + dy * dy + dz * dz);
+    }
+
+    clusters->x[c] = center[0];
+    clusters->y[c] = center[1];
+    clusters->z[c] = center[2];
+    clusters->radius[c] = sqrtf(radius);
+
+    // face normals, counter clockwise triangles facing towards their normal
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    float normals[3 * 128];
+    float *normal = n <= 3 * 128 ? normals : malloc(n * sizeof(float));
+    int nnormals = 0;
+    for(i = 0; normal && i + 2 < n; i += 3)
+    {
+        const float *a = (const float*) (vertices + indices[i] * stride);
+        const float *b = (const float*) (vertices + indices[i + 1] * stride);
+        const float *d = (const float*) (vertices + indices[i + 2] * stride);
+        float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float e2[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+        float nx = e1[1] * e2[2] - e1[2] * e2[1];
+        float ny = e1[2] * e2[0] - e1[0] * e2[2];
+        float nz = e1[0] * e2[1] - e1[1] * e2[0];
+        float len = sqrtf(nx * nx + ny * ny + nz * nz);
+        if(len == 0.0f)
+        {
+            continue; // degenerate triangles face every way, and never draw
+        }
+
+        float *m = &normal[nnormals++ * 3];
+        m[0] = nx / len;
+        m[1] = ny / len;
+        m[2] = nz / len;
+        axis[0] += m[0];
+        axis[1] += m[1];
+        axis[2] += m[2];
+    }
+
+    float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float mindot = len > 0.0f ? 1.0f : -1.0f;
+    for(i = 0; i < nnormals && len > 0.0f; i++)
+    {
+        const float *m = &normal[i * 3];
+        mindot = fminf(mindot, (m[0] * axis[0] + m[1] * axis[1] + m[2] * axis[2]) / len);
+    }
+
+    if(!normal || mindot <= 0.0f)
+    {
+        // normals span a half space or more, the cluster can always be seen
+        clusters->ax[c] = clusters->ay[c] = clusters->az[c] = 0.0f;
+        clusters->cutoff[c] = 1.0f;
+    } else
+    {
+        clusters->ax[c] = axis[0] / len;
+        clusters->ay[c] = axis[1] / len;
+        clusters->az[c] = axis[2] / len;
+        clusters->cutoff[c] = sqrtf(1.0f - mindot * mindot);
+    }
+
+    if(normal != normals)
+    {
+        free(normal);
+    }
+}
+
+/**
+ * splits the triangles of 'index' into clusters of 'ntriangles' consecutive
+ * triangles, and stores a bounding sphere and normal cone for each so that
+ * glbProgramDrawIndexedCulled can skip clusters that are off screen or back
+ * facing. 64 to 128 triangles per cluster work well. Clusters are only spatially
+ * coherent if the triangles are, so this should follow glbOptimizeIndexBuffer.
+ * The clusters are dropped when the index format changes, and must be rebuilt
+ * after the indices are written.
+ * @param array the vertices 'index' references. The first attribute of its
+ * layout is the position, and must have at least 3 GLB_FLOAT components.
+ * @param ntriangles triangles per cluster, or 0 to remove the clusters
+ */
+int glbIndexBufferClusters(GLBBuffer *index, GLBBuffer *array, int ntriangles)
+{
+    int errcode;
+    int i, c;
+    unsigned int *indices = NULL;
+    unsigned char *vertices = NULL;
+    struct GLBClusters *clusters = NULL;
+    GLB_ASSERT(index && ntriangles >= 0, GLB_INVALID_ARGUMENT, ERROR);
+
+    glbDeleteClusters(index->clusters);
+    index->clusters = NULL;
+    if(!ntriangles)
+    {
+        return GLB_SUCCESS;
+    }
+
+    GLB_ASSERT(array && array->vdata.count, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(index->idata.count % 3 == 0, GLB_INVALID_ARGUMENT, ERROR);
+    const GLBVertexLayout *position = &array->vdata.layout[0];
+    GLB_ASSERT(position->type == GLB_FLOAT && position->size >= 3, GLB_INVALID_ARGUMENT, ERROR);
+
+    size_t bytes = array->nmemb * array->sz;
+    size_t stride = position->stride ? position->stride : sizeof(float) * position->size;
+    size_t nverts = bytes >= position->offset + sizeof(float) * 3 ?
+                    (bytes - position->offset - sizeof(float) * 3) / stride + 1 : 0;
+
+    int n = index->idata.count;
+    int nclusters = (n / 3 + ntriangles - 1) / ntriangles;
+    indices = glbReadIndices(index);
+    vertices = malloc(bytes);
+    clusters = glbCreateClusters(nclusters);
+    GLB_ASSERT(indices && vertices && clusters, GLB_OUT_OF_MEMORY, ERROR);
+
+    for(i = 0; i < n; i++)
+    {
+        GLB_ASSERT(indices[i] < nverts, GLB_INVALID_ARGUMENT, ERROR);
+    }
+
+    glbReadBuffer(array, 0, bytes, vertices);
+    for(c = 0; c < nclusters; c++)
+    {
+        int first = c * ntriangles * 3;
+        int count = n - first < ntriangles * 3 ? n - first : ntriangles * 3;
+        clusters->first[c] = first;
+        clusters->nindices[c] = count;
+        glbClusterBounds(clusters, c, vertices + position->offset, stride,
+                         &indices[first], count);
+    }
+
+    free(indices);
+    free(vertices);
+    index->clusters = clusters;
+    return GLB_SUCCESS;
+
+ERROR:
+    free(indices);
+    free(vertices);
+    glbDeleteClusters(clusters);
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * @private
+ * finds the clusters not culled. A cluster is culled if glbCullFrustum culls its
+ * sphere, or if 'facing' is non-zero and its normal cone shows every triangle
+ * faces away from 'eye'.
+ * @param planes frustum planes (a, b, c, d) with a * x + b * y + c * z + d >= 0
+ * inside, or NULL
+ * @param eye view position, or NULL
+ * @param facing 1 if counter clockwise triangles are front facing, -1 if
+ * clockwise ones are, or 0 to keep back facing clusters
+ * @param visible receives the indices of visible clusters, in order
+ * @returns the number of visible clusters
+ */
+int glbClustersCull(const struct GLBClusters *clusters, const float planes[6][4],
+                    const float *eye, float facing, uint32_t *visible)
+{
+    int i;
+    int n;
+    if(planes)
+    {
+        GLBBounds bounds = {GLB_BOUNDS_SPHERE, clusters->x, clusters->y, clusters->z,
+                            clusters->radius, NULL, NULL, NULL};
+        n = glbCullFrustum(planes, &bounds, clusters->count, visible);
+    } else
+    {
+        for(i = 0; i < clusters->count; i++)
+        {
+            visible[i] = i;
+        }
+        n = clusters->count;
+    }
+
+    if(!eye || facing == 0.0f)
+    {
+        return n;
+    }
+
+    int nvisible = 0;
+    for(i = 0; i < n; i++)
+    {
+        uint32_t c = visible[i];
+        float dx = clusters->x[c] - eye[0];
+        float dy = clusters->y[c] - eye[1];
+        float dz = clusters->z[c] - eye[2];
+        float d = (dx * clusters->ax[c] + dy * clusters->ay[c] + dz * clusters->az[c]) * facing;
+        visible[nvisible] = c;
+        nvisible += d < clusters->cutoff[c] * sqrtf(dx * dx + dy * dy + dz * dz) +
+                        clusters->radius[c];
+    }
+    return nvisible;
+}/*}}}*/
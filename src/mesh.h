@@ -0,0 +1,48 @@
+/*
+ * mesh.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_MESH_H
+#define _GLB_MESH_H
+
+#include <stddef.h>
+
+#include "glb_types.h"
+
+/**
+ * precisions vertex attributes can be quantized to
+ */
+enum GLBVertexPrecision
+{
+    GLB_PRECISION_KEEP = 0, ///< copy the attribute unchanged
+    GLB_PRECISION_HALF,     ///< GLB_HALF_FLOAT
+    GLB_PRECISION_SNORM16,  ///< normalized GLB_SHORT, for values in [-1, 1]
+    GLB_PRECISION_UNORM8,   ///< normalized GLB_UNSIGNED_BYTE, for values in [0, 1]
+    GLB_PRECISION_SNORM10,  ///< normalized GLB_INT_2_10_10_10_REV, for unit vectors
+};
+
+// Buffers
+
+int glbOptimizeIndexBuffer  (GLBBuffer *index, int nverts);
+int glbOptimizeVertexBuffer (GLBBuffer *array, GLBBuffer *index);
+int glbRemapIndexBuffer     (GLBBuffer *index, GLBBuffer *array);
+int glbIndexBufferClusters  (GLBBuffer *index, GLBBuffer *array, int ntriangles);
+
+// Arrays
+
+int glbOptimizeIndices      (unsigned int *indices, size_t nindices, size_t nverts);
+int glbOptimizeVertexFetch  (void *vertices, size_t sz, size_t nverts,
+                             unsigned int *indices, size_t nindices);
+int glbWeldVertices         (void *vertices, size_t sz, size_t nverts,
+                             int ndesc, const GLBVertexLayout *desc,
+                             unsigned int *remap, size_t *nunique);
+int glbRemapIndices         (unsigned int *indices, size_t nindices,
+                             const unsigned int *remap, size_t nremap);
+int glbQuantizeVertices     (const void *src, size_t nverts,
+                             int ndesc, const GLBVertexLayout *desc,
+                             const int *precision, void *dst,
+                             GLBVertexLayout *dstdesc, size_t *dstsz);
+
+#endif
@@ -10,12 +10,15 @@
 
 #include "glb_private.h"
 
-#include <alloca.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+static void glbProgramDefaultOptions(GLBProgramOptions *options);
+static unsigned glbProgramOptionsHash(const GLBProgramOptions *options);
 
 /**
  * gets the array index for a given shader
@@ -56,6 +59,13 @@ static GLBShader *glbGetProgramShader(GLBProgram *program, int shader_index)
  */
 static int glbProgramClean(GLBProgram *program)
 {
+    // options do not require a relink
+    if(program->optionsdirty)
+    {
+        program->optionshash = glbProgramOptionsHash(&program->options);
+        program->optionsdirty = 0;
+    }
+
     if(program->dirty)
     {
         int i;
@@ -130,6 +140,8 @@ static int glbProgramClean(GLBProgram *program)
         }
 
         glLinkProgram(program->globj);
+        program->serial = glbGenSerial(); // invalidates vertex arrays cached for the old link
+        program->drawversion = 0;
 
         /*
          * convert GLBShader metadata into GLBProgram metadata. pretty much
@@ -238,9 +250,14 @@ GLBProgram *glbCreateProgram (int *errcode_ret)
 
     program->refcount = 1;
     program->dirty = 0;
+    program->serial = 0;
+    program->ndrawbuffers = 0;
+    program->drawversion = 0;
     program->ninputs = 0;
     program->noutputs = 0;
     program->nuniforms = 0;
+    glbProgramDefaultOptions(&program->options);
+    program->optionsdirty = 1;
 
     program->globj = glCreateProgram();
 
@@ -299,6 +316,7 @@ void glbDeleteProgram (GLBProgram *program)
 
     glbReleaseFramebuffer(program->framebuffer);
     //TODO: delete Identifiers
+    glbStateDeleteProgram(program->globj);
     glDeleteProgram(program->globj);
     free(program);
 }
@@ -330,21 +348,151 @@ void glbReleaseProgram (GLBProgram *program)
 }/*}}}*/
 
 /*{{{ Options */
-int glbProgramExtendOptionsList(GLBProgram *program, int n)
+static void glbProgramDefaultOptions(GLBProgramOptions *options)
 {
+    options->mode = GL_TRIANGLES;
+    options->polygon = GL_FILL;
+    options->cull = GL_NONE;
+    options->frontface = GL_CCW;
+    options->provoking = GL_LAST_VERTEX_CONVENTION;
+    options->linewidth = 1.0f;
+    options->pointsize = 1.0f;
+    options->depthtest = GL_FALSE;
+    options->depthwrite = GL_TRUE;
+    options->depthfunc = GL_LESS;
+    options->blend = GLB_BLEND_NONE;
+}
 
-    return 0;
+static unsigned glbProgramOptionsHash(const GLBProgramOptions *options)
+{
+    // FNV-1a over each field, so padding does not affect the hash
+    unsigned hash = 2166136261u;
+#define GLB_HASH_FIELD(v) hash = (hash ^ (unsigned) (v)) * 16777619u
+    GLB_HASH_FIELD(options->polygon);
+    GLB_HASH_FIELD(options->cull);
+    GLB_HASH_FIELD(options->frontface);
+    GLB_HASH_FIELD(options->provoking);
+    GLB_HASH_FIELD(options->linewidth * 16.0f);
+    GLB_HASH_FIELD(options->pointsize * 16.0f);
+    GLB_HASH_FIELD(options->depthtest);
+    GLB_HASH_FIELD(options->depthwrite);
+    GLB_HASH_FIELD(options->depthfunc);
+    GLB_HASH_FIELD(options->blend);
+#undef GLB_HASH_FIELD
+    return hash;
+}
+
+static bool glbIsPrimativeType(int value)
+{
+    switch(value)
+    {
+        case GL_POINTS:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+        case GL_LINES:
+        case GL_TRIANGLES:
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+        case GL_LINES_ADJACENCY:
+        case GL_LINE_STRIP_ADJACENCY:
+        case GL_TRIANGLES_ADJACENCY:
+        case GL_TRIANGLE_STRIP_ADJACENCY:
+        case GL_PATCHES:
+            return true;
+        default:
+            return false;
+    }
 }
 
+static bool glbIsCompareFunc(int value)
+{
+    return value == GL_NEVER || value == GL_LESS || value == GL_EQUAL ||
+           value == GL_LEQUAL || value == GL_GREATER || value == GL_NOTEQUAL ||
+           value == GL_GEQUAL || value == GL_ALWAYS;
+}
+
+/**
+ * sets a render state option used when drawing with the program. The options
+ * of a program form a single block that is hashed when the program is next
+ * cleaned; when drawing, only the settings that differ from the last drawn
+ * program's are sent to GL. Options that are never set are applied with their
+ * OpenGL default, so render state changed with raw GL calls, such as
+ * glEnable(GL_DEPTH_TEST), is overridden on the next draw.
+ * @param option the option to set, from enum GLBDrawOptions
+ * @param value the new value, as described by the option
+ * @returns 0 on success, or GLB_INVALID_ARGUMENT if the option or value is
+ * not recognized. The options are left unchanged on error.
+ */
 int glbProgramOption (GLBProgram *program, int option, int value)
 {
-    //if(program->options.noptions > program->options.maxoptions)
+    int errcode = GLB_INVALID_ARGUMENT;
+    GLBProgramOptions *options;
+    GLB_ASSERT(program, GLB_INVALID_ARGUMENT, ERROR);
+
+    options = &program->options;
+    switch(option)
     {
-        //TODO: extend
+        case GLB_NO_DRAW_OPTIONS:
+            return 0;
+        case GLB_OPTIONS_RESET:
+            glbProgramDefaultOptions(options);
+            break;
+        case GLB_POLYGON_MODE:
+            GLB_ASSERT(value == GL_FILL || value == GL_LINE || value == GL_POINT,
+                       GLB_INVALID_ARGUMENT, ERROR);
+            options->polygon = value;
+            break;
+        case GLB_CULL_MODE:
+            GLB_ASSERT(value == GL_NONE || value == GL_FRONT ||
+                       value == GL_BACK || value == GL_FRONT_AND_BACK,
+                       GLB_INVALID_ARGUMENT, ERROR);
+            options->cull = value;
+            break;
+        case GLB_PRIMATIVE_MODE:
+            GLB_ASSERT(glbIsPrimativeType(value), GLB_INVALID_ARGUMENT, ERROR);
+            options->mode = value;
+            break;
+        case GLB_FRONT_FACE_MODE:
+            GLB_ASSERT(value == GL_CCW || value == GL_CW, GLB_INVALID_ARGUMENT, ERROR);
+            options->frontface = value;
+            break;
+        case GLB_LINE_WIDTH:
+            GLB_ASSERT(value > 0, GLB_INVALID_ARGUMENT, ERROR);
+            options->linewidth = value;
+            break;
+        case GLB_POINT_SIZE:
+            GLB_ASSERT(value > 0, GLB_INVALID_ARGUMENT, ERROR);
+            options->pointsize = value;
+            break;
+        case GLB_PROVOKING_VERTEX:
+            GLB_ASSERT(value == GL_FIRST_VERTEX_CONVENTION || value == GL_LAST_VERTEX_CONVENTION,
+                       GLB_INVALID_ARGUMENT, ERROR);
+            options->provoking = value;
+            break;
+        case GLB_DEPTH_TEST:
+            options->depthtest = value ? GL_TRUE : GL_FALSE;
+            break;
+        case GLB_DEPTH_FUNC:
+            GLB_ASSERT(glbIsCompareFunc(value), GLB_INVALID_ARGUMENT, ERROR);
+            options->depthfunc = value;
+            break;
+        case GLB_DEPTH_WRITE:
+            options->depthwrite = value ? GL_TRUE : GL_FALSE;
+            break;
+        case GLB_BLEND_MODE:
+            GLB_ASSERT(value >= GLB_BLEND_NONE && value <= GLB_BLEND_ADDITIVE,
+                       GLB_INVALID_ARGUMENT, ERROR);
+            options->blend = value;
+            break;
+        default:
+            goto ERROR;
     }
 
-    //TODO: set program options
-    GLB_RETURN_ERROR(GLB_UNIMPLEMENTED);
+    program->optionsdirty = 1;
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
 }/*}}}*/
 
 /*{{{ Shaders*/
@@ -500,7 +648,7 @@ static int glbProgramUniformIdent(GLBProgram *program, GLBProgramIdent *ident,
         //return GLB_INVALID_ARGUMENT;
     }
 
-    glUseProgram(program->globj);
+    glbStateUseProgram(program->globj);
     if(glbTypeIsMatrix(ident->type))
     {
         switch(ident->type)
@@ -617,8 +765,8 @@ static int glbProgramUniformIdent(GLBProgram *program, GLBProgramIdent *ident,
             case GLB_SAMPLER_1D_ARRAY:
             case GLB_SAMPLER_2D_ARRAY:
                 //TODO: bind textures to shader
-                glActiveTexture(GL_TEXTURE0 + ident->order);
-                glBindTexture(((GLBTexture*)val)->target, ((GLBTexture*)val)->globj);
+                glbStateActiveTexture(ident->order);
+                glbStateBindTexture(((GLBTexture*)val)->target, ((GLBTexture*)val)->globj);
                 glUniform1i(ident->location, ident->order); //TODO: order might collide between shaders
                 break;
             default:
@@ -629,12 +777,9 @@ static int glbProgramUniformIdent(GLBProgram *program, GLBProgramIdent *ident,
         errcode = GLB_INVALID_ARGUMENT;
         goto ERROR;
     }
-    glUseProgram(0);
     return errcode;
 
 ERROR:
-    glUseProgram(0);
-
     return errcode;
 }
 
@@ -829,6 +974,161 @@ int glbProgramOutput (GLBProgram *program, GLBFramebuffer *output)
 /*}}}*/
 
 /*{{{ Draw */
+
+/**
+ * specifies the vertex attributes used to draw 'array' with 'program'. Expects
+ * the vertex array object that is being specified, and 'array', to be bound.
+ * If the buffer has a layout, the layout is used, else the layout is guessed from
+ * the first 'ninputs' program inputs.
+ * @returns the number of attributes specified
+ */
+static int glbProgramVertexAttributes(GLBProgram *program, GLBBuffer *array, int ninputs)
+{
+    int i;
+    if(array->vdata.layout)
+    {
+        for(i = 0; i < array->vdata.count; i++)
+        {
+            GLBVertexLayout *layout = &array->vdata.layout[i];
+            glEnableVertexAttribArray(i); //TODO check for int (AttribIPointer)
+            size_t offset = array->offset + layout->offset;
+            if(program->inputs[i] && program->inputs[i]->isInt)
+            {
+                glVertexAttribIPointer(i, layout->size, layout->type,
+                                      layout->stride, (void*) offset);
+            } else
+            {
+                glVertexAttribPointer(i, layout->size, layout->type, layout->normalized,
+                                      layout->stride, (void*) offset);
+            }
+
+            if(layout->divisor)
+            {
+                glVertexAttribDivisor(i, layout->divisor);
+            }
+        }
+        return array->vdata.count;
+    } else // this assumes each attrib in the shader is sequential and (usually) float type
+    {
+        size_t attrib_offset = array->offset;
+        for(i = 0; i < ninputs; i++)
+        {
+            int attrib_type = program->inputs[i]->type;
+            int attrib_len = glbTypeLength(attrib_type);
+            int attrib_size = glbTypeSizeof(attrib_type);
+            glEnableVertexAttribArray(i);
+            //TODO: change GL_FLOAT 
+            if(program->inputs[i]->isInt)
+            {
+                glVertexAttribIPointer(program->inputs[i]->location,
+                                       attrib_len, GL_INT,
+                                       attrib_size, //TODO handle arrays
+                                       (void*) attrib_offset);
+            } else //expected
+            {
+                glVertexAttribPointer(program->inputs[i]->location,
+                                      attrib_len, GL_FLOAT, GL_FALSE,
+                                      attrib_size, //TODO: handle arrays
+                                      (void*) attrib_offset);
+            }
+            attrib_offset += attrib_size;
+        }
+        return ninputs;
+    }
+}
+
+/**
+ * specifies the per-instance attributes read from 'instance', starting at
+ * attribute 'first'. The instance buffer must have a layout; attributes with a
+ * divisor of 0 advance once per instance.
+ */
+static void glbProgramInstanceAttributes(GLBProgram *program, GLBBuffer *instance, int first)
+{
+    int i;
+    glbStateBindBuffer(GL_ARRAY_BUFFER, instance->globj);
+    for(i = 0; i < instance->vdata.count; i++)
+    {
+        GLBVertexLayout *layout = &instance->vdata.layout[i];
+        int location = first + i;
+        glEnableVertexAttribArray(location);
+        size_t offset = instance->offset + layout->offset;
+        if(location < program->ninputs && program->inputs[location]->isInt)
+        {
+            glVertexAttribIPointer(location, layout->size, layout->type,
+                                   layout->stride, (void*) offset);
+        } else
+        {
+            glVertexAttribPointer(location, layout->size, layout->type, layout->normalized,
+                                  layout->stride, (void*) offset);
+        }
+        glVertexAttribDivisor(location, layout->divisor ? layout->divisor : 1);
+    }
+}
+
+/**
+ * binds a vertex array object holding the attribute setup to draw 'array',
+ * 'instance' and 'index' with 'program'. Vertex arrays are cached on the vertex
+ * buffer, keyed by the program link, instance buffer, index buffer and the
+ * offsets of the vertex and instance buffers, so a repeated draw only binds the
+ * cached object, and a GLBDynamicBuffer keeps one per region. The cache is cleared when the
+ * buffer's layout changes or the buffer is deleted; a relink or a layout change
+ * of the other buffers gives them a new serial which no cached entry matches.
+ */
+static void glbProgramBindVertexArray(GLBProgram *program, GLBBuffer *array,
+                                      GLBBuffer *instance, GLBBuffer *index)
+{
+    int i;
+    unsigned nserial = instance ? instance->serial : 0;
+    unsigned iserial = index ? index->serial : 0;
+    size_t noffset = instance ? instance->offset : 0;
+    struct GLBVertexArray *vao;
+
+    for(i = 0; i < array->nvertexarrays; i++)
+    {
+        vao = &array->vertexarrays[i];
+        if(vao->program == program->serial &&
+           vao->instance == nserial && vao->index == iserial &&
+           vao->offset == array->offset && vao->instanceoffset == noffset)
+        {
+            glbStateBindVertexArray(vao->globj);
+            return;
+        }
+    }
+
+    if(array->nvertexarrays < GLB_MAX_VERTEX_ARRAYS)
+    {
+        vao = &array->vertexarrays[array->nvertexarrays];
+        array->nvertexarrays++;
+    } else // cache full, replace the oldest entry
+    {
+        vao = &array->vertexarrays[array->nextvertexarray];
+        array->nextvertexarray = (array->nextvertexarray + 1) % GLB_MAX_VERTEX_ARRAYS;
+        glbStateDeleteVertexArray(vao->globj);
+        glDeleteVertexArrays(1, &vao->globj);
+    }
+
+    glGenVertexArrays(1, &vao->globj);
+    vao->program = program->serial;
+    vao->instance = nserial;
+    vao->index = iserial;
+    vao->offset = array->offset;
+    vao->instanceoffset = noffset;
+
+    glbStateBindVertexArray(vao->globj);
+    glbStateBindBuffer(GL_ARRAY_BUFFER, array->globj);
+    if(index)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index->globj); // part of the vertex array state
+    }
+
+    int ninputs = program->ninputs - (instance ? instance->vdata.count : 0);
+    int nattribs = glbProgramVertexAttributes(program, array, MAX(ninputs, 0));
+    if(instance)
+    {
+        glbProgramInstanceAttributes(program, instance, nattribs);
+    }
+}
+
 int glbProgramDraw (GLBProgram *program, GLBBuffer *array)
 {
     if(array) 
@@ -856,45 +1156,60 @@ int glbProgramDrawRange (GLBProgram *program, GLBBuffer *array, int offset, int
     GLB_RETURN_ERROR(glbProgramDrawIndexedRange(program, array, NULL, offset, count));
 }
 
-int glbProgramDrawIndexedRange (GLBProgram *program, GLBBuffer *array,
-                                GLBBuffer *index, int offset, int count)
+/**
+ * sets the color attachments written by each program output on 'framebuffer',
+ * which must be bound. The mapping is computed once per program link and
+ * attachment set. Since draw buffers are part of the framebuffer object state,
+ * GL is only called if another program or attachment set was drawn with since.
+ */
+static void glbProgramDrawBuffers(GLBProgram *program, GLBFramebuffer *framebuffer)
 {
     int i;
-    int mode = GL_TRIANGLES;
 
-    glbProgramClean(program);
+    if(program->drawversion != framebuffer->version)
+    {
+        program->ndrawbuffers = MIN(program->noutputs, framebuffer->ncolors);
+        for(i = 0; i < program->ndrawbuffers; i++)
+        {
+            program->drawbuffers[i] = GL_COLOR_ATTACHMENT0 + program->outputs[i]->location;
+        }
+        program->drawversion = framebuffer->version;
+    }
 
-    if(!program->shaders[0]) // cannot draw if theres no VERTEX SHADER
+    if(framebuffer->drawprogram != program->serial ||
+       framebuffer->drawversion != framebuffer->version)
     {
-        GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+        glDrawBuffers(program->ndrawbuffers, program->drawbuffers);
+        framebuffer->drawprogram = program->serial;
+        framebuffer->drawversion = framebuffer->version;
     }
+}
 
-    glUseProgram(program->globj);
-    glBindBuffer(GL_ARRAY_BUFFER, array->globj);
+/**
+ * binds the program, its framebuffer, draw buffers and textures for drawing.
+ */
+static int glbProgramBind(GLBProgram *program)
+{
+    int i;
 
-    if(index)
+    glbProgramClean(program);
+
+    if(!program->shaders[0]) // cannot draw if theres no VERTEX SHADER
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index->globj);
+        return GLB_INVALID_ARGUMENT;
     }
-    
+
+    glbStateUseProgram(program->globj);
+    glbStateApplyOptions(&program->options, program->optionshash);
+
     if(program->framebuffer)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, program->framebuffer->globj);
+        glbStateBindFramebuffer(program->framebuffer->globj);
+        glbProgramDrawBuffers(program, program->framebuffer);
     } else 
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    } //TODO re-enable once framebuffers work
-
-    // set correct draw buffers
-    int noutputs = program->framebuffer ? 
-                   MIN(program->noutputs, program->framebuffer->ncolors) : 1;
-    noutputs = program->noutputs;
-    GLenum *drawbufs = alloca(sizeof(GLenum) * program->noutputs);
-    for (i = 0; i < noutputs; i++)
-    {
-        drawbufs[i] = GL_COLOR_ATTACHMENT0 + program->outputs[i]->location;
+        glbStateBindFramebuffer(0); // the default framebuffer keeps its own draw buffer
     }
-    glDrawBuffers(noutputs, drawbufs);
 
     // bind all textures
     
@@ -903,67 +1218,460 @@ int glbProgramDrawIndexedRange (GLBProgram *program, GLBBuffer *array,
         if(program->textures[i])
         {
             GLBTexture *tex = program->textures[i];
-            glActiveTexture(GL_TEXTURE0 + i);
-            glBindTexture(tex->target, tex->globj);
+            glbStateActiveTexture(i);
+            glbStateBindTexture(tex->target, tex->globj);
         }
     }
 
-    // bind correct vertex data locations
-    // if a layout is given, use the layout, else guess from the program
-    if(array->vdata.layout)
+    return 0;
+}
+
+/**
+ * the primitive type drawn by the program.
+ */
+static GLenum glbProgramMode(GLBProgram *program)
+{
+    return program->options.mode;
+}
+
+/**
+ * counts the vertices 'array' holds, from the stride and offset of its first
+ * attribute, or 0 if it has no layout.
+ */
+static size_t glbProgramVertexCount(GLBBuffer *array)
+{
+    if(!array->vdata.count)
     {
-        for(i = 0; i < array->vdata.count; i++)
+        return 0;
+    }
+
+    const GLBVertexLayout *layout = &array->vdata.layout[0];
+    size_t bytes = array->nmemb * array->sz;
+    size_t asz = glbVertexLayoutSizeof(layout);
+    size_t stride = layout->stride ? layout->stride : asz;
+    return stride && bytes >= layout->offset + asz ?
+           (bytes - layout->offset - asz) / stride + 1 : 0;
+}
+
+/**
+ * issues the draw call. Expects the program and vertex array to be bound.
+ * @param offset the first vertex, or the first index relative to the index
+ * buffer's format offset if 'index' is given
+ * @param count the number of vertices or indices to draw
+ * @param basevertex added to each index before fetching the vertex
+ */
+static void glbProgramSubmit(GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                             int offset, int count, int basevertex, int instances)
+{
+    GLenum mode = glbProgramMode(program);
+
+    if(!index)
+    {
+        if(instances != 1)
         {
-            GLBVertexLayout *layout = &array->vdata.layout[i];
-            glEnableVertexAttribArray(i); //TODO check for int (AttribIPointer)
-            if(program->inputs[i] && program->inputs[i]->isInt)
-            {
-                glVertexAttribIPointer(i, layout->size, layout->type,
-                                      layout->stride, (void*) layout->offset);
-            } else
-            {
-                glVertexAttribPointer(i, layout->size, layout->type, layout->normalized,
-                                      layout->stride, (void*) layout->offset);
-            }
+            glDrawArraysInstanced(mode, offset, count, instances);
+        } else
+        {
+            glDrawArrays(mode, offset, count);
         }
-    } else // this assumes each attrib in the shader is sequential and (usually) float type
+        return;
+    }
+
+    GLenum type = index->idata.type;
+    void *first = (void*) (index->offset +
+                           (size_t) (index->idata.offset + offset) * glbTypeSizeof(type));
+
+    if(instances != 1)
     {
-        int attrib_offset = 0;
-        for(i = 0; i < program->ninputs; i++)
+        if(basevertex)
         {
-            int attrib_type = program->inputs[i]->type;
-            int attrib_len = glbTypeLength(attrib_type);
-            int attrib_size = glbTypeSizeof(attrib_type);
-            glEnableVertexAttribArray(i);
-            //TODO: change GL_FLOAT 
-            if(program->inputs[i]->isInt)
-            {
-                glVertexAttribIPointer(program->inputs[i]->location,
-                                       attrib_len, GL_INT,
-                                       attrib_size, //TODO handle arrays
-                                       (void*) attrib_offset);
-            } else //expected
-            {
-                glVertexAttribPointer(program->inputs[i]->location,
-                                      attrib_len, GL_FLOAT, GL_FALSE,
-                                      attrib_size, //TODO: handle arrays
-                                      (void*) attrib_offset);
-            }
-            attrib_offset += attrib_size;
+            glDrawElementsInstancedBaseVertex(mode, count, type, first, instances, basevertex);
+        } else
+        {
+            glDrawElementsInstanced(mode, count, type, first, instances);
+        }
+    } else if(basevertex)
+    {
+        glDrawElementsBaseVertex(mode, count, type, first, basevertex);
+    } else
+    {
+        // the vertex range lets the driver skip scanning the indices
+        size_t nverts = glbProgramVertexCount(array);
+        if(nverts)
+        {
+            glDrawRangeElements(mode, 0, nverts - 1, count, type, first);
+        } else
+        {
+            glDrawElements(mode, count, type, first);
+        }
+    }
+}
+
+/**
+ * checks that a range of 'count' indices starting at 'first' lies within the
+ * index buffer, or a range of vertices within the vertex buffer if there is
+ * no index buffer.
+ */
+static bool glbProgramRangeValid(GLBBuffer *array, GLBBuffer *index, int first, int count)
+{
+    int n = index ? index->idata.count : (int) array->nmemb;
+    return first >= 0 && count >= 0 && first <= n - count;
+}
+
+/**
+ * draws part of 'array'.
+ * @param index optional index buffer
+ * @param offset the first index to draw, counted from the start of the index
+ * buffer's format. The first vertex if there is no index buffer.
+ * @param count the number of indices, or vertices, to draw
+ */
+int glbProgramDrawIndexedRange (GLBProgram *program, GLBBuffer *array,
+                                GLBBuffer *index, int offset, int count)
+{
+    GLB_RETURN_ERROR(glbProgramDrawIndexedBaseVertex(program, array, index,
+                                                     offset, count, 0));
+}
+
+/**
+ * draws part of 'index', adding 'basevertex' to each index before the vertex
+ * is fetched from 'array'. Many meshes can share one vertex buffer and one
+ * index buffer, each drawn with its own first index and base vertex, so that
+ * indices stay relative to the start of their mesh.
+ * @param first the first index to draw, counted from the start of the index
+ * buffer's format
+ * @param count the number of indices to draw
+ * @param basevertex value added to each index. Requires OpenGL 3.2 if non-zero.
+ */
+int glbProgramDrawIndexedBaseVertex (GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                                     int first, int count, int basevertex)
+{
+    int errcode;
+    GLB_ASSERT(program && array, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(glbProgramRangeValid(array, index, first, count), GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(!basevertex || glbCanUseFeature(GLB_DRAW_BASE_VERTEX_FEATURE),
+               GLB_GL_TOO_OLD, ERROR);
+
+    errcode = glbProgramBind(program);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    glbProgramBindVertexArray(program, array, NULL, index);
+    glbProgramSubmit(program, array, index, first, count, basevertex, 1);
+
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+static int glbProgramDrawInstancedRange (GLBProgram *program, GLBBuffer *array,
+                                         GLBBuffer *index, GLBBuffer *instance,
+                                         int offset, int count, int ninstances)
+{
+    int errcode;
+    GLB_ASSERT(program && array && ninstances >= 0, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(!instance || instance->vdata.layout, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(glbCanUseFeature(GLB_INSTANCED_ARRAYS_FEATURE), GLB_GL_TOO_OLD, ERROR);
+
+    errcode = glbProgramBind(program);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    glbProgramBindVertexArray(program, array, instance, index);
+    glbProgramSubmit(program, array, index, offset, count, 0, ninstances);
+
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * draws 'ninstances' copies of 'array' with a single GL call.
+ * @param instance optional buffer of per-instance attributes. It must have a
+ * layout, and its attributes follow those of 'array' in location order. Each
+ * attribute advances once every 'divisor' instances, or every instance if its
+ * divisor is 0. Without it, instances can be told apart by gl_InstanceID.
+ * @param ninstances the number of copies to draw
+ */
+int glbProgramDrawInstanced (GLBProgram *program, GLBBuffer *array,
+                             GLBBuffer *instance, int ninstances)
+{
+    if(!array) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    GLB_RETURN_ERROR(glbProgramDrawInstancedRange(program, array, NULL, instance,
+                                                  0, array->nmemb, ninstances));
+}
+
+/**
+ * draws 'ninstances' copies of 'array', indexed by 'index', with a single GL call.
+ * Instance attributes are the same as for glbProgramDrawInstanced.
+ */
+int glbProgramDrawIndexedInstanced (GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                                    GLBBuffer *instance, int ninstances)
+{
+    if(!array || !index) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    GLB_RETURN_ERROR(glbProgramDrawInstancedRange(program, array, index, instance,
+                                                  0, index->idata.count, ninstances));
+}
+
+/**
+ * draws the clusters of 'index' that survive culling, see glbIndexBufferClusters.
+ * Clusters whose bounding sphere is outside the frustum are skipped, as are
+ * clusters facing away from 'eye' when the program culls back faces. Consecutive
+ * visible clusters are merged into one range. Without clusters the whole index
+ * buffer is drawn.
+ * @param planes frustum planes (a, b, c, d) with a * x + b * y + c * z + d >= 0
+ * inside, in the space of the vertex positions, or NULL
+ * @param eye view position in the same space, or NULL
+ */
+int glbProgramDrawIndexedCulled (GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                                 const float planes[6][4], const float eye[3])
+{
+    int errcode;
+    int i;
+    GLB_ASSERT(program && array && index, GLB_INVALID_ARGUMENT, ERROR);
+
+    struct GLBClusters *clusters = index->clusters;
+    if(!clusters)
+    {
+        GLB_RETURN_ERROR(glbProgramDrawIndexed(program, array, index));
+    }
+
+    // the normal cones only describe filled triangles culled by winding
+    const GLBProgramOptions *options = &program->options;
+    float facing = 0.0f;
+    if(options->mode == GL_TRIANGLES && options->cull == GL_BACK)
+    {
+        facing = options->frontface == GL_CW ? -1.0f : 1.0f;
+    }
+
+    int nvisible = glbClustersCull(clusters, planes, eye, facing, clusters->visible);
+    if(!nvisible)
+    {
+        return 0;
+    }
+
+    GLenum type = index->idata.type;
+    int isz = glbTypeSizeof(type);
+    int nruns = 0;
+    int end = -1;
+    for(i = 0; i < nvisible; i++)
+    {
+        uint32_t c = clusters->visible[i];
+        if(clusters->first[c] == end)
+        {
+            clusters->runcount[nruns - 1] += clusters->nindices[c];
+        } else
+        {
+            clusters->runcount[nruns] = clusters->nindices[c];
+            clusters->runfirst[nruns] = (const void*) (index->offset +
+                (size_t) (index->idata.offset + clusters->first[c]) * isz);
+            nruns++;
         }
+        end = clusters->first[c] + clusters->nindices[c];
     }
 
+    errcode = glbProgramBind(program);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    glbProgramBindVertexArray(program, array, NULL, index);
+    glMultiDrawElements(glbProgramMode(program), clusters->runcount, type,
+                        clusters->runfirst, nruns);
+
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * draws a list of items in order. Each item is equivilent to setting the item's
+ * uniforms and textures with glbProgramUniform and glbProgramTexture, then calling
+ * glbProgramDrawIndexedRange. Unlike separate calls, only the state that differs
+ * from the previous item is sent to GL: neighbouring items with the same program
+ * skip the program setup, and items that also share vertex and index buffers skip
+ * the vertex array setup. Sorting items by program, then by buffers, gives the
+ * most reuse.
+ * @param items the array of items to draw
+ * @param n the number of items
+ * @returns 0 on success, or the first error encountered. Items before the failing
+ * item will have been drawn.
+ */
+int glbProgramDrawBatch (GLBDrawItem *items, int n)
+{
+    int errcode = 0;
+    int i, j;
+    GLBDrawItem *prev = NULL;
+
+    for(i = 0; i < n; i++)
+    {
+        GLBDrawItem *item = &items[i];
+        GLB_ASSERT(item->program && item->array, GLB_INVALID_ARGUMENT, ERROR);
+        GLB_ASSERT(glbProgramRangeValid(item->array, item->index, item->offset, item->count),
+                   GLB_INVALID_ARGUMENT, ERROR);
+        GLB_ASSERT(!item->basevertex || glbCanUseFeature(GLB_DRAW_BASE_VERTEX_FEATURE),
+                   GLB_GL_TOO_OLD, ERROR);
+
+        for(j = 0; j < item->nuniforms; j++)
+        {
+            GLBDrawUniform *u = &item->uniforms[j];
+            errcode = glbProgramUniform(item->program, u->shader, u->i, u->sz, u->val);
+            GLB_ASSERT(!errcode, errcode, ERROR);
+        }
+
+        // textures are bound to their unit as they are set
+        for(j = 0; j < item->ntextures; j++)
+        {
+            GLBDrawTexture *t = &item->textures[j];
+            errcode = glbProgramTexture(item->program, t->shader, t->i, t->texture);
+            GLB_ASSERT(!errcode, errcode, ERROR);
+        }
+
+        if(!prev || prev->program != item->program)
+        {
+            errcode = glbProgramBind(item->program);
+            GLB_ASSERT(!errcode, errcode, ERROR);
+        }
+
+        if(!prev || prev->program != item->program ||
+           prev->array != item->array || prev->index != item->index)
+        {
+            glbProgramBindVertexArray(item->program, item->array, NULL, item->index);
+        }
+
+        glbProgramSubmit(item->program, item->array, item->index,
+                         item->offset, item->count, item->basevertex, 1);
+        prev = item;
+    }
+
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * draws using a command stored in a GLBBuffer, so that the draw parameters can
+ * be written by the GPU or uploaded once and reused.
+ * @param array the vertex buffer
+ * @param index optional index buffer. If given, the command is read as a
+ * GLBDrawIndexedIndirectCommand, otherwise as a GLBDrawIndirectCommand. GL
+ * counts the command's first index from the start of the GL buffer, so the
+ * index buffer must not be a heap view or be formatted with an offset.
+ * @param commands buffer holding the command
+ * @param offset byte offset of the command in 'commands'
+ */
+int glbProgramDrawIndirect (GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                            GLBBuffer *commands, size_t offset)
+{
+    int errcode;
+    GLB_ASSERT(program && array && commands, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(glbCanUseFeature(GLB_DRAW_INDIRECT_BUFFER_FEATURE), GLB_GL_TOO_OLD, ERROR);
+    GLB_ASSERT(!index || (!index->offset && !index->idata.offset), GLB_INVALID_ARGUMENT, ERROR);
+
+    errcode = glbProgramBind(program);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    glbProgramBindVertexArray(program, array, NULL, index);
+    glbStateBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->globj);
+
+    if(index)
+    {
+        glDrawElementsIndirect(glbProgramMode(program), index->idata.type,
+                               (void*) (commands->offset + offset));
+    } else
+    {
+        glDrawArraysIndirect(glbProgramMode(program), (void*) (commands->offset + offset));
+    }
+
+    return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * draws a list of commands stored in a GLBBuffer with a single GL call. All
+ * commands share the program, vertex buffer and index buffer, so many meshes
+ * packed into the same buffers can be drawn at once.
+ * @param array the vertex buffer
+ * @param index optional index buffer, decides the command type and has the
+ * same restrictions as for glbProgramDrawIndirect
+ * @param commands buffer holding the commands
+ * @param offset byte offset of the first command in 'commands'
+ * @param drawcount number of commands to draw
+ * @param stride bytes between the start of each command, or 0 if they are
+ * tightly packed
+ */
+int glbProgramMultiDrawIndirect (GLBProgram *program, GLBBuffer *array, GLBBuffer *index,
+                                 GLBBuffer *commands, size_t offset,
+                                 int drawcount, int stride)
+{
+    int errcode;
+    GLB_ASSERT(program && array && commands && drawcount >= 0 && stride >= 0,
+               GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(glbCanUseFeature(GLB_MULTI_DRAW_INDIRECT_FEATURE), GLB_GL_TOO_OLD, ERROR);
+    GLB_ASSERT(!index || (!index->offset && !index->idata.offset), GLB_INVALID_ARGUMENT, ERROR);
+
+    if(!drawcount) return 0;
+
+    errcode = glbProgramBind(program);
+    GLB_ASSERT(!errcode, errcode, ERROR);
+
+    glbProgramBindVertexArray(program, array, NULL, index);
+    glbStateBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->globj);
+
     if(index)
     {
-        glDrawElements(mode, index->idata.count, index->idata.type, 0);
+        glMultiDrawElementsIndirect(glbProgramMode(program), index->idata.type,
+                                    (void*) (commands->offset + offset), drawcount, stride);
     } else
     {
-        glDrawArrays(mode, offset, count);
+        glMultiDrawArraysIndirect(glbProgramMode(program), (void*) (commands->offset + offset),
+                                  drawcount, stride);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glUseProgram(0);
     return 0;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * fills an array of non-indexed commands, one instance each.
+ * @param commands the array to fill, of at least 'n' commands
+ * @param first the first vertex of each draw
+ * @param count the number of vertices of each draw
+ */
+void glbFillIndirectCommands (GLBDrawIndirectCommand *commands, int n,
+                              const int *first, const int *count)
+{
+    int i;
+    for(i = 0; i < n; i++)
+    {
+        commands[i].count = count[i];
+        commands[i].instances = 1;
+        commands[i].first = first[i];
+        commands[i].baseinstance = 0;
+    }
+}
+
+/**
+ * fills an array of indexed commands, one instance each.
+ * @param commands the array to fill, of at least 'n' commands
+ * @param first the first index of each draw
+ * @param count the number of indices of each draw
+ * @param basevertex optional, the value added to each index of each draw
+ */
+void glbFillIndexedIndirectCommands (GLBDrawIndexedIndirectCommand *commands, int n,
+                                     const int *first, const int *count,
+                                     const int *basevertex)
+{
+    int i;
+    for(i = 0; i < n; i++)
+    {
+        commands[i].count = count[i];
+        commands[i].instances = 1;
+        commands[i].first = first[i];
+        commands[i].basevertex = basevertex ? basevertex[i] : 0;
+        commands[i].baseinstance = 0;
+    }
 }/*}}}*/
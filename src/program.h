@@ -17,6 +17,72 @@
 #define GLB_MAX_INPUTS      16
 #define GLB_MAX_OUTPUTS     16
 
+/**
+ * a uniform value set before drawing a GLBDrawItem.
+ * Arguments are the same as for glbProgramUniform.
+ */
+struct GLBDrawUniform
+{
+    int shader; ///< shader stage the uniform is defined in (eg GLB_VERTEX_SHADER)
+    int i;      ///< order the uniform is defined in the shader
+    int sz;     ///< size of the value in bytes
+    void *val;
+};
+
+/**
+ * a texture bound before drawing a GLBDrawItem.
+ * Arguments are the same as for glbProgramTexture.
+ */
+struct GLBDrawTexture
+{
+    int shader;
+    int i;
+    GLBTexture *texture;
+};
+
+/**
+ * a single draw submitted through glbProgramDrawBatch. The range is the same
+ * as for glbProgramDrawIndexedBaseVertex. 'index', 'uniforms' and 'textures' are optional.
+ */
+struct GLBDrawItem
+{
+    GLBProgram *program;
+    GLBBuffer *array;
+    GLBBuffer *index;
+    int offset;
+    int count;
+    int nuniforms;
+    struct GLBDrawUniform *uniforms;
+    int ntextures;
+    struct GLBDrawTexture *textures;
+    int basevertex; ///< added to each index, as for glbProgramDrawIndexedBaseVertex
+};
+
+/**
+ * a draw command read from a GLBBuffer by glbProgramDrawIndirect when drawing
+ * without an index buffer. The layout is fixed by GL.
+ */
+struct GLBDrawIndirectCommand
+{
+    unsigned int count;        ///< number of vertices
+    unsigned int instances;    ///< number of instances, usually 1
+    unsigned int first;        ///< first vertex
+    unsigned int baseinstance; ///< must be 0 before GL 4.2
+};
+
+/**
+ * a draw command read from a GLBBuffer by glbProgramDrawIndirect when drawing
+ * with an index buffer. The layout is fixed by GL.
+ */
+struct GLBDrawIndexedIndirectCommand
+{
+    unsigned int count;        ///< number of indices
+    unsigned int instances;    ///< number of instances, usually 1
+    unsigned int first;        ///< first index
+    int basevertex;            ///< added to each index before fetching the vertex
+    unsigned int baseinstance; ///< must be 0 before GL 4.2
+};
+
 // Initialization/Deinitialization
 
 GLBProgram *glbCreateProgram              (int *errcode_ret); //TODO: really need errcode?
@@ -25,7 +91,6 @@ void        glbRetainProgram              (GLBProgram *program);
 void        glbReleaseProgram             (GLBProgram *program);
 
 // Options
-//TODO: allow non-triangles, wireframe, other options
 
 int         glbProgramOption              (GLBProgram *program, int option, int value);
 
@@ -87,4 +152,44 @@ int         glbProgramDrawIndexedRange    (GLBProgram *program,
                                            GLBBuffer *index,
                                            int offset, int count);
 
+int         glbProgramDrawIndexedBaseVertex(GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *index,
+                                           int first, int count, int basevertex);
+
+int         glbProgramDrawInstanced       (GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *instance, int ninstances);
+
+int         glbProgramDrawIndexedInstanced(GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *index,
+                                           GLBBuffer *instance, int ninstances);
+
+int         glbProgramDrawIndexedCulled   (GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *index,
+                                           const float planes[6][4],
+                                           const float eye[3]);
+
+int         glbProgramDrawBatch           (GLBDrawItem *items, int n);
+
+int         glbProgramDrawIndirect        (GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *index,
+                                           GLBBuffer *commands, size_t offset);
+
+int         glbProgramMultiDrawIndirect   (GLBProgram *program,
+                                           GLBBuffer *array,
+                                           GLBBuffer *index,
+                                           GLBBuffer *commands, size_t offset,
+                                           int drawcount, int stride);
+
+void        glbFillIndirectCommands       (GLBDrawIndirectCommand *commands, int n,
+                                           const int *first, const int *count);
+
+void        glbFillIndexedIndirectCommands(GLBDrawIndexedIndirectCommand *commands, int n,
+                                           const int *first, const int *count,
+                                           const int *basevertex);
+
 #endif
@@ -0,0 +1,130 @@
+/**
+ * readback.c
+ * @file readback.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBReadback object interface
+ *
+ * glbReadBuffer stalls until the GPU has finished everything that writes the
+ * buffer. A readback instead copies the range into a staging buffer on the GPU,
+ * and fences the copy. The returned ticket is polled or waited on, and once the
+ * fence has signalled, mapping the staging buffer does not stall. Results read a
+ * frame or two after they are requested are usually ready without waiting.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * starts reading 'sz' bytes of the buffer at 'offset'. The contents are those
+ * left by the commands issued before this call; later writes are not seen.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ * @returns a ticket with a reference count of 1, to get the data from
+ */
+GLBReadback *glbReadBufferAsync(GLBBuffer *buffer, size_t offset, size_t sz,
+                                int *errcode_ret)
+{
+    int errcode;
+    GLBReadback *ticket = NULL;
+    GLB_ASSERT(buffer && sz, GLB_INVALID_ARGUMENT, ERROR);
+    GLB_ASSERT(offset + sz <= buffer->nmemb * buffer->sz && offset + sz >= offset,
+               GLB_INVALID_ARGUMENT, ERROR);
+
+    ticket = calloc(1, sizeof(GLBReadback));
+    GLB_ASSERT(ticket, GLB_OUT_OF_MEMORY, ERROR);
+    ticket->refcount = 1;
+
+    ticket->staging = glbCreateBuffer(sz, 1, NULL, GLB_STREAM_READ, &errcode);
+    GLB_ASSERT(ticket->staging, errcode, ERROR);
+    glbCopyBuffer(buffer, ticket->staging, offset, 0, sz);
+
+    ticket->fence = glbCreateFence(&errcode);
+    GLB_ASSERT(ticket->fence, errcode, ERROR);
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return ticket;
+
+ERROR:
+    glbDeleteReadback(ticket);
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteReadback(GLBReadback *ticket)
+{
+    if(!ticket) return;
+    if(ticket->map)
+    {
+        glbUnmapBuffer(ticket->staging);
+    }
+    glbReleaseFence(ticket->fence);
+    glbReleaseBuffer(ticket->staging);
+    free(ticket);
+}
+
+void glbRetainReadback(GLBReadback *ticket)
+{
+    if(!ticket) return;
+    ticket->refcount++;
+}
+
+void glbReleaseReadback(GLBReadback *ticket)
+{
+    if(!ticket) return;
+    ticket->refcount--;
+    if(ticket->refcount <= 0)
+    {
+        glbDeleteReadback(ticket);
+    }
+}/*}}}*/
+
+/*{{{ Results*/
+/**
+ * waits up to 'timeout' nanoseconds for the copy to be done. A timeout of 0 only
+ * polls. The first wait flushes the GL commands, so the copy is sure to start.
+ * @returns 0 once the data is ready, or GLB_TIMEOUT
+ */
+int glbReadbackWait(GLBReadback *ticket, uint64_t timeout)
+{
+    if(!ticket) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    return glbFenceWait(ticket->fence, timeout);
+}
+
+/**
+ * polls the ticket without waiting.
+ * @returns true if the data can be mapped without stalling
+ */
+bool glbReadbackReady(GLBReadback *ticket)
+{
+    return ticket && glbReadbackWait(ticket, 0) == GLB_SUCCESS;
+}
+
+/**
+ * maps the data read back, waiting for it if it is not ready yet. The mapping
+ * stays valid until the ticket is deleted.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ * @returns the data, or NULL on error
+ */
+const void *glbReadbackMap(GLBReadback *ticket, int *errcode_ret)
+{
+    int errcode;
+    GLB_ASSERT(ticket, GLB_INVALID_ARGUMENT, ERROR);
+
+    if(!ticket->map)
+    {
+        errcode = glbReadbackWait(ticket, GL_TIMEOUT_IGNORED);
+        GLB_ASSERT(!errcode, errcode, ERROR);
+        ticket->map = glbMapBuffer(ticket->staging, GLB_READ_ONLY);
+        GLB_ASSERT(ticket->map, GLB_MAP_ERROR, ERROR);
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return ticket->map;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}/*}}}*/
@@ -0,0 +1,26 @@
+/*
+ * readback.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_READBACK_H
+#define _GLB_READBACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "glb_types.h"
+
+GLBReadback *glbReadBufferAsync      (GLBBuffer *buffer, size_t offset, size_t sz,
+                                      int *errcode_ret);
+void         glbDeleteReadback       (GLBReadback *ticket);
+void         glbRetainReadback       (GLBReadback *ticket);
+void         glbReleaseReadback      (GLBReadback *ticket);
+
+bool         glbReadbackReady        (GLBReadback *ticket);
+int          glbReadbackWait         (GLBReadback *ticket, uint64_t timeout);
+const void  *glbReadbackMap          (GLBReadback *ticket, int *errcode_ret);
+
+#endif
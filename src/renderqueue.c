@@ -0,0 +1,283 @@
+/**
+ * renderqueue.c
+ * @file renderqueue.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBRenderQueue object interface
+ *
+ * A render queue collects draws during a frame and submits them in an order that
+ * minimises state changes. Each draw is given a 64 bit key, packed from most to
+ * least significant as:
+ *
+ *  bits  | field
+ *  ------|--------------------------------------
+ *  63-56 | framebuffer the program draws into
+ *  55-40 | program
+ *  39-28 | texture set
+ *  27-16 | vertex and index buffers
+ *  15-0  | depth
+ *
+ * Object fields are hashes of the object, so unrelated objects may share a value.
+ * This only costs some state reuse; draws are never mixed up since the key only
+ * decides the order. Keys are sorted with an LSD radix sort, and the sorted draws
+ * are submitted through glbProgramDrawBatch.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define GLB_KEY_FRAMEBUFFER_BITS 8
+#define GLB_KEY_PROGRAM_BITS    16
+#define GLB_KEY_TEXTURE_BITS    12
+#define GLB_KEY_BUFFER_BITS     12
+#define GLB_KEY_DEPTH_BITS      16
+
+#define GLB_KEY_DEPTH_SHIFT       0
+#define GLB_KEY_BUFFER_SHIFT      (GLB_KEY_DEPTH_SHIFT + GLB_KEY_DEPTH_BITS)
+#define GLB_KEY_TEXTURE_SHIFT     (GLB_KEY_BUFFER_SHIFT + GLB_KEY_BUFFER_BITS)
+#define GLB_KEY_PROGRAM_SHIFT     (GLB_KEY_TEXTURE_SHIFT + GLB_KEY_TEXTURE_BITS)
+#define GLB_KEY_FRAMEBUFFER_SHIFT (GLB_KEY_PROGRAM_SHIFT + GLB_KEY_PROGRAM_BITS)
+
+/*{{{ Keys*/
+/**
+ * fibonacci hash of a value, reduced to 'bits' bits. 0 always hashes to 0.
+ */
+static uint64_t glbKeyMix(uint64_t value, int bits)
+{
+    return (value * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits);
+}
+
+static uint64_t glbKeyHash(const void *ptr, int bits)
+{
+    return glbKeyMix((uintptr_t) ptr, bits);
+}
+
+/**
+ * converts a float to bits that sort in the same order as the float, and
+ * keeps the most significant ones.
+ */
+static uint64_t glbKeyDepth(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(uint32_t));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return bits >> (32 - GLB_KEY_DEPTH_BITS);
+}
+
+static uint64_t glbRenderQueueKey(const GLBDrawItem *item, float depth)
+{
+    int i;
+    uint64_t textures = 0;
+    for(i = 0; i < item->ntextures; i++)
+    {
+        textures = textures * 31 + glbKeyHash(item->textures[i].texture, 32);
+    }
+
+    uint64_t buffers = glbKeyHash(item->array, 32) ^ (glbKeyHash(item->index, 32) >> 1);
+
+    return (glbKeyHash(item->program->framebuffer, GLB_KEY_FRAMEBUFFER_BITS)
+                << GLB_KEY_FRAMEBUFFER_SHIFT) |
+           (glbKeyHash(item->program, GLB_KEY_PROGRAM_BITS) << GLB_KEY_PROGRAM_SHIFT) |
+           (glbKeyMix(textures, GLB_KEY_TEXTURE_BITS) << GLB_KEY_TEXTURE_SHIFT) |
+           (glbKeyMix(buffers, GLB_KEY_BUFFER_BITS) << GLB_KEY_BUFFER_SHIFT) |
+           (glbKeyDepth(depth) << GLB_KEY_DEPTH_SHIFT);
+}
+
+/**
+ * sorts 'order' by 'keys', one byte per pass starting with the least significant.
+ * Passes in which every key has the same byte are skipped.
+ * @returns the array holding the sorted order, either 'order' or 'tmporder'
+ */
+static uint32_t *glbRadixSort(uint64_t *keys, uint32_t *order,
+                              uint64_t *tmpkeys, uint32_t *tmporder, int n)
+{
+    int pass, i;
+    size_t count[256];
+
+    for(pass = 0; pass < 8; pass++)
+    {
+        int shift = pass * 8;
+        memset(count, 0, sizeof(count));
+        for(i = 0; i < n; i++)
+        {
+            count[(keys[i] >> shift) & 0xff]++;
+        }
+
+        if(count[(keys[0] >> shift) & 0xff] == n)
+        {
+            continue;
+        }
+
+        size_t sum = 0;
+        for(i = 0; i < 256; i++)
+        {
+            size_t c = count[i];
+            count[i] = sum;
+            sum += c;
+        }
+
+        for(i = 0; i < n; i++)
+        {
+            size_t dst = count[(keys[i] >> shift) & 0xff]++;
+            tmpkeys[dst] = keys[i];
+            tmporder[dst] = order[i];
+        }
+
+        uint64_t *k = keys;
+        keys = tmpkeys;
+        tmpkeys = k;
+        uint32_t *o = order;
+        order = tmporder;
+        tmporder = o;
+    }
+
+    return order;
+}/*}}}*/
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates a new, empty render queue with a reference count of 1.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBRenderQueue *glbCreateRenderQueue(int *errcode_ret)
+{
+    int errcode;
+    GLBRenderQueue *queue = malloc(sizeof(GLBRenderQueue));
+    GLB_ASSERT(queue, GLB_OUT_OF_MEMORY, ERROR);
+
+    queue->refcount = 1;
+    queue->nitems = 0;
+    queue->maxitems = 0;
+    queue->items = NULL;
+    queue->sorted = NULL;
+    queue->keys = NULL;
+    queue->tmpkeys = NULL;
+    queue->order = NULL;
+    queue->tmporder = NULL;
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return queue;
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteRenderQueue(GLBRenderQueue *queue)
+{
+    if(!queue) return;
+    free(queue->items);
+    free(queue->sorted);
+    free(queue->keys);
+    free(queue->tmpkeys);
+    free(queue->order);
+    free(queue->tmporder);
+    free(queue);
+}
+
+void glbRetainRenderQueue(GLBRenderQueue *queue)
+{
+    if(!queue) return;
+    queue->refcount++;
+}
+
+void glbReleaseRenderQueue(GLBRenderQueue *queue)
+{
+    if(!queue) return;
+    queue->refcount--;
+    if(queue->refcount <= 0)
+    {
+        glbDeleteRenderQueue(queue);
+    }
+}/*}}}*/
+
+/*{{{ Drawing*/
+static int glbRenderQueueGrow(GLBRenderQueue *queue)
+{
+    int max = queue->maxitems ? queue->maxitems * 2 : 64;
+
+    // each array is replaced as it succeeds, so the queue stays usable on failure
+#define GLB_QUEUE_GROW(field) \
+    do { \
+        void *tmp = realloc(queue->field, sizeof(*queue->field) * max); \
+        if(!tmp) return GLB_OUT_OF_MEMORY; \
+        queue->field = tmp; \
+    } while(0)
+
+    GLB_QUEUE_GROW(items);
+    GLB_QUEUE_GROW(sorted);
+    GLB_QUEUE_GROW(keys);
+    GLB_QUEUE_GROW(tmpkeys);
+    GLB_QUEUE_GROW(order);
+    GLB_QUEUE_GROW(tmporder);
+#undef GLB_QUEUE_GROW
+
+    queue->maxitems = max;
+    return GLB_SUCCESS;
+}
+
+/**
+ * adds a draw to the queue. The item is copied, but any uniform values and
+ * texture lists it points to must remain valid until the queue is submitted.
+ * @param queue the queue to add to
+ * @param item the draw, as for glbProgramDrawBatch
+ * @param depth sorts draws that share all state. Smaller values are drawn first,
+ * so passing view depth draws front to back.
+ */
+int glbRenderQueueDraw(GLBRenderQueue *queue, const GLBDrawItem *item, float depth)
+{
+    int errcode;
+    GLB_ASSERT(queue && item && item->program && item->array, GLB_INVALID_ARGUMENT, ERROR);
+
+    if(queue->nitems >= queue->maxitems)
+    {
+        errcode = glbRenderQueueGrow(queue);
+        GLB_ASSERT(!errcode, errcode, ERROR);
+    }
+
+    queue->items[queue->nitems] = *item;
+    queue->keys[queue->nitems] = glbRenderQueueKey(item, depth);
+    queue->order[queue->nitems] = queue->nitems;
+    queue->nitems++;
+    return GLB_SUCCESS;
+
+ERROR:
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * sorts the queued draws by framebuffer, program, textures, buffers and depth,
+ * draws them, and empties the queue. Draws into different framebuffers are
+ * reordered too; if one pass reads what another renders, give each pass its own
+ * queue and submit them in order.
+ * @returns 0 on success, or the first error returned by glbProgramDrawBatch
+ */
+int glbRenderQueueSubmit(GLBRenderQueue *queue)
+{
+    int i;
+    if(!queue) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    if(!queue->nitems) return GLB_SUCCESS;
+
+    uint32_t *order = glbRadixSort(queue->keys, queue->order,
+                                   queue->tmpkeys, queue->tmporder, queue->nitems);
+    for(i = 0; i < queue->nitems; i++)
+    {
+        queue->sorted[i] = queue->items[order[i]];
+    }
+
+    int errcode = glbProgramDrawBatch(queue->sorted, queue->nitems);
+    queue->nitems = 0;
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * discards all queued draws without drawing them.
+ */
+void glbRenderQueueClear(GLBRenderQueue *queue)
+{
+    if(!queue) return;
+    queue->nitems = 0;
+}/*}}}*/
@@ -0,0 +1,21 @@
+/*
+ * renderqueue.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_RENDERQUEUE_H
+#define _GLB_RENDERQUEUE_H
+
+#include "glb_types.h"
+
+GLBRenderQueue *glbCreateRenderQueue   (int *errcode_ret);
+void            glbDeleteRenderQueue   (GLBRenderQueue *queue);
+void            glbRetainRenderQueue   (GLBRenderQueue *queue);
+void            glbReleaseRenderQueue  (GLBRenderQueue *queue);
+
+int             glbRenderQueueDraw     (GLBRenderQueue *queue, const GLBDrawItem *item, float depth);
+int             glbRenderQueueSubmit   (GLBRenderQueue *queue);
+void            glbRenderQueueClear    (GLBRenderQueue *queue);
+
+#endif
@@ -0,0 +1,419 @@
+/**
+ * @internal
+ * state.c
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief shadow of the OpenGL binding state
+ *
+ * GLB keeps a copy of the objects it last bound to the GL context, so that
+ * binding an object that is already bound does not result in a GL call. The
+ * render state set by program options is shadowed the same way. Since
+ * GLB functions no longer restore default bindings, the shadow is only valid
+ * as long as all binding goes through GLB. Code that mixes in raw GL calls
+ * must call glbUnbindState before them and glbInvalidateStateCache after.
+ *
+ * GLB currently assumes a single GL context, so there is a single shadow.
+ */
+
+#include "glb_private.h"
+
+#include <stdbool.h>
+
+#define GLB_UNKNOWN_BINDING ((GLuint) -1)
+
+///@private
+enum GLBStateBufferTarget
+{
+    GLB_STATE_ARRAY_BUFFER,
+    GLB_STATE_COPY_READ_BUFFER,
+    GLB_STATE_COPY_WRITE_BUFFER,
+    GLB_STATE_DRAW_INDIRECT_BUFFER,
+    GLB_STATE_PIXEL_PACK_BUFFER,
+    GLB_STATE_PIXEL_UNPACK_BUFFER,
+    GLB_STATE_UNIFORM_BUFFER,
+    GLB_STATE_NBUFFER_TARGETS,
+};
+
+///@private
+struct GLBTextureBinding
+{
+    GLenum target;
+    GLuint globj;
+};
+
+///@private
+struct GLBState
+{
+    GLuint program;
+    GLuint vertexarray;
+    GLuint framebuffer;
+    GLuint buffers[GLB_STATE_NBUFFER_TARGETS];
+    int activetexture; ///< active texture unit, -1 if unknown
+    struct GLBTextureBinding textures[GLB_MAX_TEXTURES];
+    bool optionsvalid;          ///< false if the render state is unknown
+    unsigned optionshash;       ///< hash of the last applied options
+    struct GLBProgramOptions options; ///< last applied options
+};
+
+static struct GLBState state;
+static bool state_valid = false;
+
+static struct GLBState *glbState(void)
+{
+    if(!state_valid)
+    {
+        glbInvalidateStateCache();
+    }
+    return &state;
+}
+
+/**
+ * maps a buffer target to its slot in the shadow, or -1 if it is not shadowed.
+ * GL_ELEMENT_ARRAY_BUFFER is not shadowed since it is part of the vertex array state.
+ */
+static int glbStateBufferSlot(GLenum target)
+{
+    switch(target)
+    {
+        case GL_ARRAY_BUFFER:
+            return GLB_STATE_ARRAY_BUFFER;
+        case GL_COPY_READ_BUFFER:
+            return GLB_STATE_COPY_READ_BUFFER;
+        case GL_COPY_WRITE_BUFFER:
+            return GLB_STATE_COPY_WRITE_BUFFER;
+        case GL_DRAW_INDIRECT_BUFFER:
+            return GLB_STATE_DRAW_INDIRECT_BUFFER;
+        case GL_PIXEL_PACK_BUFFER:
+            return GLB_STATE_PIXEL_PACK_BUFFER;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return GLB_STATE_PIXEL_UNPACK_BUFFER;
+        case GL_UNIFORM_BUFFER:
+            return GLB_STATE_UNIFORM_BUFFER;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * forgets all GL bindings GLB has recorded. Must be called after any raw GL
+ * calls that change the program, vertex array, buffer, framebuffer or texture
+ * bindings, the active texture unit, or any render state set by program
+ * options. The next GLB call needing any of those bindings will then bind them
+ * unconditionally.
+ *
+ * This does not change what is bound. GLB leaves its last vertex array bound,
+ * so call glbUnbindState before raw GL calls instead.
+ */
+void glbInvalidateStateCache(void)
+{
+    int i;
+    state.program = GLB_UNKNOWN_BINDING;
+    state.vertexarray = GLB_UNKNOWN_BINDING;
+    state.framebuffer = GLB_UNKNOWN_BINDING;
+    for(i = 0; i < GLB_STATE_NBUFFER_TARGETS; i++)
+    {
+        state.buffers[i] = GLB_UNKNOWN_BINDING;
+    }
+    state.activetexture = -1;
+    for(i = 0; i < GLB_MAX_TEXTURES; i++)
+    {
+        state.textures[i].target = 0;
+        state.textures[i].globj = GLB_UNKNOWN_BINDING;
+    }
+    state.optionsvalid = false;
+    state_valid = true;
+}
+
+/**
+ * binds vertex array 0 and forgets all other GL bindings GLB has recorded. Must
+ * be called before raw GL calls that set up vertex state, such as
+ * glVertexAttribPointer or binding a GL_ELEMENT_ARRAY_BUFFER, since those would
+ * otherwise change the vertex array GLB left bound, which it reuses for later
+ * draws. Call glbInvalidateStateCache after the raw GL calls if they changed
+ * any bindings.
+ */
+void glbUnbindState(void)
+{
+    glbInvalidateStateCache();
+    glBindVertexArray(0);
+    state.vertexarray = 0;
+}
+
+/*{{{ Binding*/
+void glbStateUseProgram(GLuint program)
+{
+    struct GLBState *s = glbState();
+    if(s->program != program)
+    {
+        glUseProgram(program);
+        s->program = program;
+    }
+}
+
+void glbStateBindVertexArray(GLuint vertexarray)
+{
+    struct GLBState *s = glbState();
+    if(s->vertexarray != vertexarray)
+    {
+        glBindVertexArray(vertexarray);
+        s->vertexarray = vertexarray;
+    }
+}
+
+void glbStateBindBuffer(GLenum target, GLuint buffer)
+{
+    struct GLBState *s = glbState();
+    int slot = glbStateBufferSlot(target);
+    if(slot < 0)
+    {
+        glBindBuffer(target, buffer);
+    } else if(s->buffers[slot] != buffer)
+    {
+        glBindBuffer(target, buffer);
+        s->buffers[slot] = buffer;
+    }
+}
+
+void glbStateBindFramebuffer(GLuint framebuffer)
+{
+    struct GLBState *s = glbState();
+    if(s->framebuffer != framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        s->framebuffer = framebuffer;
+    }
+}
+
+void glbStateActiveTexture(int unit)
+{
+    struct GLBState *s = glbState();
+    if(s->activetexture != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        s->activetexture = unit;
+    }
+}
+
+/**
+ * binds a texture to the active texture unit.
+ */
+void glbStateBindTexture(GLenum target, GLuint texture)
+{
+    struct GLBState *s = glbState();
+    int unit = s->activetexture;
+    if(unit < 0 || unit >= GLB_MAX_TEXTURES)
+    {
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if(s->textures[unit].target != target || s->textures[unit].globj != texture)
+    {
+        glBindTexture(target, texture);
+        s->textures[unit].target = target;
+        s->textures[unit].globj = texture;
+    }
+}/*}}}*/
+
+/*{{{ Render State*/
+static bool glbStateOptionsEqual(const struct GLBProgramOptions *a,
+                                 const struct GLBProgramOptions *b)
+{
+    return a->polygon == b->polygon &&
+           a->cull == b->cull &&
+           a->frontface == b->frontface &&
+           a->provoking == b->provoking &&
+           a->linewidth == b->linewidth &&
+           a->pointsize == b->pointsize &&
+           a->depthtest == b->depthtest &&
+           a->depthwrite == b->depthwrite &&
+           a->depthfunc == b->depthfunc &&
+           a->blend == b->blend;
+}
+
+static void glbStateEnable(GLenum cap, bool enable)
+{
+    if(enable)
+    {
+        glEnable(cap);
+    } else
+    {
+        glDisable(cap);
+    }
+}
+
+static void glbStateBlendFunc(int blend)
+{
+    switch(blend)
+    {
+        case GLB_BLEND_ALPHA:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case GLB_BLEND_PREMULTIPLIED:
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case GLB_BLEND_ADDITIVE:
+            glBlendFunc(GL_ONE, GL_ONE);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * applies the render state of a program. Only the settings that differ from
+ * the last applied options are sent to GL; if the hashes match, the options
+ * are compared as a whole first.
+ * @param hash hash of 'options', computed when the program was cleaned
+ */
+void glbStateApplyOptions(const struct GLBProgramOptions *options, unsigned hash)
+{
+    struct GLBState *s = glbState();
+    struct GLBProgramOptions *cur = &s->options;
+    bool all = !s->optionsvalid;
+
+    if(!all && s->optionshash == hash && glbStateOptionsEqual(cur, options))
+    {
+        return;
+    }
+
+    if(all || cur->polygon != options->polygon)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, options->polygon);
+    }
+
+    if(all || (cur->cull == GL_NONE) != (options->cull == GL_NONE))
+    {
+        glbStateEnable(GL_CULL_FACE, options->cull != GL_NONE);
+    }
+
+    if(options->cull != GL_NONE && (all || cur->cull != options->cull))
+    {
+        glCullFace(options->cull);
+    }
+
+    if(all || cur->frontface != options->frontface)
+    {
+        glFrontFace(options->frontface);
+    }
+
+    if(all || cur->provoking != options->provoking)
+    {
+        glProvokingVertex(options->provoking);
+    }
+
+    if(all || cur->linewidth != options->linewidth)
+    {
+        glLineWidth(options->linewidth);
+    }
+
+    if(all || cur->pointsize != options->pointsize)
+    {
+        glPointSize(options->pointsize);
+    }
+
+    if(all || cur->depthtest != options->depthtest)
+    {
+        glbStateEnable(GL_DEPTH_TEST, options->depthtest);
+    }
+
+    if(all || cur->depthfunc != options->depthfunc)
+    {
+        glDepthFunc(options->depthfunc);
+    }
+
+    if(all || cur->depthwrite != options->depthwrite)
+    {
+        glDepthMask(options->depthwrite);
+    }
+
+    if(all || (cur->blend == GLB_BLEND_NONE) != (options->blend == GLB_BLEND_NONE))
+    {
+        glbStateEnable(GL_BLEND, options->blend != GLB_BLEND_NONE);
+    }
+
+    if(options->blend != GLB_BLEND_NONE && (all || cur->blend != options->blend))
+    {
+        glbStateBlendFunc(options->blend);
+    }
+
+    *cur = *options;
+    s->optionshash = hash;
+    s->optionsvalid = true;
+}
+
+/**
+ * enables depth writes, which glClear obeys, regardless of the options of the
+ * last program drawn.
+ */
+void glbStateDepthWrite(void)
+{
+    struct GLBState *s = glbState();
+    if(!s->optionsvalid || !s->options.depthwrite)
+    {
+        glDepthMask(GL_TRUE);
+        s->options.depthwrite = GL_TRUE;
+    }
+}/*}}}*/
+
+/*{{{ Deletion*/
+/*
+ * GL reverts bindings of deleted objects to 0. These must be called when GLB
+ * deletes an object, or a new object reusing the name would be assumed bound.
+ */
+
+void glbStateDeleteProgram(GLuint program)
+{
+    struct GLBState *s = glbState();
+    if(s->program == program)
+    {
+        // a program in use is not deleted until it is no longer in use
+        glUseProgram(0);
+        s->program = 0;
+    }
+}
+
+void glbStateDeleteVertexArray(GLuint vertexarray)
+{
+    struct GLBState *s = glbState();
+    if(s->vertexarray == vertexarray)
+    {
+        s->vertexarray = 0;
+    }
+}
+
+void glbStateDeleteBuffer(GLuint buffer)
+{
+    struct GLBState *s = glbState();
+    int i;
+    for(i = 0; i < GLB_STATE_NBUFFER_TARGETS; i++)
+    {
+        if(s->buffers[i] == buffer)
+        {
+            s->buffers[i] = 0;
+        }
+    }
+}
+
+void glbStateDeleteFramebuffer(GLuint framebuffer)
+{
+    struct GLBState *s = glbState();
+    if(s->framebuffer == framebuffer)
+    {
+        s->framebuffer = 0;
+    }
+}
+
+void glbStateDeleteTexture(GLuint texture)
+{
+    struct GLBState *s = glbState();
+    int i;
+    for(i = 0; i < GLB_MAX_TEXTURES; i++)
+    {
+        if(s->textures[i].globj == texture)
+        {
+            s->textures[i].globj = 0;
+        }
+    }
+}/*}}}*/
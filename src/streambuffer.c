@@ -0,0 +1,209 @@
+/**
+ * streambuffer.c
+ * @file streambuffer.h
+ * GLB
+ * @date October 17, 2026
+ *
+ * @brief definition of the GLBStreamBuffer object interface
+ *
+ * A stream buffer hands out sub-allocations of a GL buffer for data written once
+ * per frame, such as streamed vertices. The buffer is split into regions, and
+ * each frame allocates from the next region in turn. When a frame ends, a fence
+ * is inserted after the draws reading its region; before the region is reused
+ * that fence is waited on, which normally has long been signalled. Writes never
+ * wait for the GPU otherwise.
+ *
+ * With buffer storage (GL 4.4) the buffer is mapped once, persistent and
+ * coherent. Otherwise the unwritten rest of the region is mapped with
+ * GL_MAP_INVALIDATE_RANGE_BIT on the first allocation after a flush, and
+ * unmapped by the flush. Synchronization is then left to the fences, or without
+ * sync objects the buffer is orphaned each time the regions wrap around.
+ */
+
+#include "glb_private.h"
+
+#include <stdlib.h>
+
+/*{{{ Initialization/Deinitialization*/
+/**
+ * creates a stream buffer of 'nregions' regions of 'size' bytes each. A frame may
+ * allocate at most one region; 3 regions let the CPU run 2 frames ahead.
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ */
+GLBStreamBuffer *glbCreateStreamBuffer(size_t size, int nregions, int *errcode_ret)
+{
+    int errcode;
+    GLBStreamBuffer *stream = NULL;
+    GLB_ASSERT(size && nregions > 0 && nregions <= GLB_MAX_STREAM_REGIONS,
+               GLB_INVALID_ARGUMENT, ERROR);
+
+    stream = calloc(1, sizeof(GLBStreamBuffer));
+    GLB_ASSERT(stream, GLB_OUT_OF_MEMORY, ERROR);
+    stream->refcount = 1;
+    stream->regionsize = size;
+    stream->nregions = nregions;
+
+    size_t total = size * nregions;
+    stream->persistent = glbCanUseFeature(GLB_BUFFER_STORAGE_FEATURE);
+    if(stream->persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        stream->buffer = glbCreateBufferStorage(total, flags, &errcode);
+        GLB_ASSERT(stream->buffer, errcode, ERROR);
+
+        stream->map = glbMapBufferRange(stream->buffer, 0, total, flags);
+        GLB_ASSERT(stream->map, GLB_MAP_ERROR, ERROR);
+    } else
+    {
+        stream->buffer = glbCreateBuffer(total, 1, NULL, GLB_STREAM_DRAW, &errcode);
+        GLB_ASSERT(stream->buffer, errcode, ERROR);
+    }
+
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return stream;
+
+ERROR:
+    glbDeleteStreamBuffer(stream);
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+void glbDeleteStreamBuffer(GLBStreamBuffer *stream)
+{
+    int i;
+    if(!stream) return;
+    if(stream->map && stream->buffer)
+    {
+        glbUnmapBuffer(stream->buffer);
+    }
+    for(i = 0; i < GLB_MAX_STREAM_REGIONS; i++)
+    {
+        glbReleaseFence(stream->fences[i]);
+    }
+    glbReleaseBuffer(stream->buffer);
+    free(stream);
+}
+
+void glbRetainStreamBuffer(GLBStreamBuffer *stream)
+{
+    if(!stream) return;
+    stream->refcount++;
+}
+
+void glbReleaseStreamBuffer(GLBStreamBuffer *stream)
+{
+    if(!stream) return;
+    stream->refcount--;
+    if(stream->refcount <= 0)
+    {
+        glbDeleteStreamBuffer(stream);
+    }
+}/*}}}*/
+
+/*{{{ Streaming*/
+/**
+ * allocates 'size' bytes from the current frame's region. The memory can be
+ * written until the next glbStreamBufferFlush, and is read by draws issued after
+ * it until the region is reused, 'nregions' frames later.
+ * @param align the offset is a multiple of this, eg. the vertex size for drawing
+ * with a base vertex of offset / align. 0 is treated as 1.
+ * @param offset_ret returns the byte offset of the allocation in the buffer
+ * @param errcode_ret optional parameter that returns non-zero on error.
+ * GLB_OUT_OF_MEMORY if the region is full.
+ * @returns a pointer to write the data to, or NULL on error
+ */
+void *glbStreamBufferAlloc(GLBStreamBuffer *stream, size_t size, size_t align,
+                           size_t *offset_ret, int *errcode_ret)
+{
+    int errcode;
+    GLB_ASSERT(stream && offset_ret, GLB_INVALID_ARGUMENT, ERROR);
+
+    if(!align) align = 1;
+    size_t end = (stream->region + 1) * stream->regionsize;
+    size_t offset = (stream->head + align - 1) / align * align;
+    GLB_ASSERT(offset <= end && size <= end - offset, GLB_OUT_OF_MEMORY, ERROR);
+
+    if(!stream->map)
+    {
+        // the fences, or orphaning, keep the GPU off the rest of the region
+        int access = GLB_MAP_WRITE_BIT | GLB_MAP_INVALIDATE_RANGE_BIT |
+                     GLB_MAP_FLUSH_EXPLICIT_BIT | GLB_MAP_UNSYNCHRONIZED_BIT;
+        stream->map = glbMapBufferRange(stream->buffer, offset, end - offset, access);
+        GLB_ASSERT(stream->map, GLB_MAP_ERROR, ERROR);
+        stream->mapoffset = offset;
+    }
+
+    stream->head = offset + size;
+    *offset_ret = offset;
+    GLB_SET_ERROR(GLB_SUCCESS);
+    return stream->map + (offset - stream->mapoffset);
+
+ERROR:
+    GLB_SET_ERROR(errcode);
+    return NULL;
+}
+
+/**
+ * makes the data written to allocations visible to draws issued after this call.
+ * Allocations must not be written after the flush.
+ */
+int glbStreamBufferFlush(GLBStreamBuffer *stream)
+{
+    if(!stream) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+
+    // coherent mappings need no flush
+    if(stream->persistent || !stream->map)
+    {
+        return GLB_SUCCESS;
+    }
+
+    glbFlushMappedBufferRange(stream->buffer, 0, stream->head - stream->mapoffset);
+    GLboolean ok = glbUnmapBuffer(stream->buffer);
+    stream->map = NULL;
+    GLB_RETURN_ERROR(ok ? GLB_SUCCESS : GLB_MAP_ERROR);
+}
+
+/**
+ * ends the frame, after all of its draws are issued. The data is flushed, the
+ * region is fenced, and allocation moves to the next region once the GPU is done
+ * reading it.
+ */
+int glbStreamBufferFrame(GLBStreamBuffer *stream)
+{
+    if(!stream) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+
+    int errcode = glbStreamBufferFlush(stream);
+    bool sync = glbCanUseFeature(GLB_SYNC_FEATURE);
+    if(sync)
+    {
+        stream->fences[stream->region] = glbCreateFence(NULL);
+    }
+
+    stream->region = (stream->region + 1) % stream->nregions;
+    stream->head = stream->region * stream->regionsize;
+
+    GLBFence *fence = stream->fences[stream->region];
+    if(fence)
+    {
+        glbFenceWait(fence, GL_TIMEOUT_IGNORED);
+        glbReleaseFence(fence);
+        stream->fences[stream->region] = NULL;
+    } else if(!sync && !stream->region)
+    {
+        // no fences: wrapping around orphans the buffer, the GPU keeps the old storage
+        glbStateBindBuffer(GL_COPY_WRITE_BUFFER, stream->buffer->globj);
+        glBufferData(GL_COPY_WRITE_BUFFER, stream->regionsize * stream->nregions,
+                     NULL, GLB_STREAM_DRAW);
+    }
+
+    GLB_RETURN_ERROR(errcode);
+}
+
+/**
+ * gets the GL buffer allocations are made from, to draw from or to give a vertex
+ * or index format. The buffer is owned by the stream buffer.
+ */
+GLBBuffer *glbStreamBufferBuffer(GLBStreamBuffer *stream)
+{
+    return stream ? stream->buffer : NULL;
+}/*}}}*/
@@ -0,0 +1,25 @@
+/*
+ * streambuffer.h
+ * GLB
+ * October 17, 2026
+ */
+
+#ifndef _GLB_STREAMBUFFER_H
+#define _GLB_STREAMBUFFER_H
+
+#include <stddef.h>
+
+#include "glb_types.h"
+
+GLBStreamBuffer *glbCreateStreamBuffer   (size_t size, int nregions, int *errcode_ret);
+void             glbDeleteStreamBuffer   (GLBStreamBuffer *stream);
+void             glbRetainStreamBuffer   (GLBStreamBuffer *stream);
+void             glbReleaseStreamBuffer  (GLBStreamBuffer *stream);
+
+void            *glbStreamBufferAlloc    (GLBStreamBuffer *stream, size_t size, size_t align,
+                                          size_t *offset_ret, int *errcode_ret);
+int              glbStreamBufferFlush    (GLBStreamBuffer *stream);
+int              glbStreamBufferFrame    (GLBStreamBuffer *stream);
+GLBBuffer       *glbStreamBufferBuffer   (GLBStreamBuffer *stream);
+
+#endif
@@ -94,6 +94,8 @@ GLBTexture* glbCreateTexture (int flags,
     texture->dim[2] = z;
     texture->format = format;
     texture->sampler = NULL;
+    texture->fencewrites = false;
+    texture->fence = NULL;
     texture->size = x * y * z * FORMAT[format].depth; //TODO: assert format is correct
 
     switch(glbTextureDimensions(texture))
@@ -108,7 +110,7 @@ GLBTexture* glbCreateTexture (int flags,
                 texture->target = GL_TEXTURE_3D;
             }
 
-            glBindTexture(texture->target, texture->globj);
+            glbStateBindTexture(texture->target, texture->globj);
             glTexImage3D(texture->target, 0, FORMAT[format].internalFormat,
                          x, y, z, 0, FORMAT[format].format, FORMAT[format].type, ptr);
             break;
@@ -121,13 +123,13 @@ GLBTexture* glbCreateTexture (int flags,
                 texture->target = GL_TEXTURE_2D;
             }
 
-            glBindTexture(texture->target, texture->globj);
+            glbStateBindTexture(texture->target, texture->globj);
             glTexImage2D(texture->target, 0, FORMAT[format].internalFormat,
                          x, y, 0, FORMAT[format].format, FORMAT[format].type, ptr);
             break;
         case 1:
             texture->target = GL_TEXTURE_1D;
-            glBindTexture(texture->target, texture->globj);
+            glbStateBindTexture(texture->target, texture->globj);
             glTexImage1D(texture->target, 0, FORMAT[format].internalFormat,
                          x, 0, FORMAT[format].format, FORMAT[format].type, ptr);
             break;
@@ -143,6 +145,7 @@ GLBTexture* glbCreateTexture (int flags,
     return texture;
 
 UNKNOWN_ERROR:
+    glbStateDeleteTexture(texture->globj);
     glDeleteTextures(1, &texture->globj);
     free(texture);
 ERROR:
@@ -203,7 +206,9 @@ int glbDeleteTexture (GLBTexture *texture)
 {
     if(!texture) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
 
+    glbStateDeleteTexture(texture->globj);
     glDeleteTextures(1, &texture->globj);
+    glbReleaseFence(texture->fence);
     return 0;
 }
 
@@ -229,7 +234,7 @@ int glbReleaseTexture(GLBTexture *texture)
 
 int glbTextureGenerateMipmap(GLBTexture *texture)
 {
-    glBindTexture(texture->target, texture->globj);
+    glbStateBindTexture(texture->target, texture->globj);
     glGenerateMipmap(texture->target);
     if(!texture->sampler)
     {
@@ -251,7 +256,7 @@ int glbTextureSampler (GLBTexture *texture, struct GLBSampler *sampler)
     glbRetainSampler(sampler);
     texture->sampler = sampler;
 
-    glBindTexture(texture->target, texture->globj);
+    glbStateBindTexture(texture->target, texture->globj);
     glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, sampler->minfilter);
     glTexParameteri(texture->target, GL_TEXTURE_MAG_FILTER, sampler->magfilter);
     glTexParameteri(texture->target, GL_TEXTURE_WRAP_S, sampler->wrap_s);
@@ -260,7 +265,6 @@ int glbTextureSampler (GLBTexture *texture, struct GLBSampler *sampler)
     glTexParameterf(texture->target, GL_TEXTURE_MIN_LOD, sampler->minlod);
     glTexParameterf(texture->target, GL_TEXTURE_MAX_LOD, sampler->maxlod);
     //TODO: other params
-    glBindTexture(texture->target, 0);
 
     return 0;
 }
@@ -310,7 +314,7 @@ int glbWriteTexture (GLBTexture *texture, int level, int *origin, int *region,
 {
     if(!texture || !ptr) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
 
-    glBindTexture(texture->target, texture->globj);
+    glbStateBindTexture(texture->target, texture->globj);
 
     struct GLBTextureFormat *format = &FORMAT[writefmt];
     if(format->depth * region[0] * region[1] > size) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
@@ -320,22 +324,28 @@ int glbWriteTexture (GLBTexture *texture, int level, int *origin, int *region,
         case GL_TEXTURE_1D:
             glTexSubImage1D(texture->target, level, origin[0],
                             region[0], format->format, format->type, ptr);
-            return 0;
+            break;
         case GL_TEXTURE_2D:
         case GL_TEXTURE_1D_ARRAY:
             glTexSubImage2D(texture->target, level, origin[0], origin[1],
                             region[0], region[1], format->format, format->type, ptr);
-            return 0;
+            break;
 
         case GL_TEXTURE_3D:
         case GL_TEXTURE_2D_ARRAY:
             glTexSubImage3D(texture->target, level, origin[0], origin[1], origin[2],
                              region[0], region[1], region[2], 
                              format->format, format->type, ptr);
-            return 0;
+            break;
         default:
             GLB_RETURN_ERROR(GLB_UNIMPLEMENTED);
     }
+
+    if(texture->fencewrites)
+    {
+        glbFenceReplace(&texture->fence);
+    }
+    return 0;
 }
 
 int glbWriteTextureWithTGA(GLBTexture *texture, int level, int *origin, int *region,
@@ -389,7 +399,7 @@ int glbReadTexture (GLBTexture *texture, int level, const int *const origin,
 {
     if(!texture || !ptr) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
 
-    glBindTexture(texture->target, texture->globj);
+    glbStateBindTexture(texture->target, texture->globj);
 
     int x = 0;
     int y = 0;
@@ -509,3 +519,37 @@ const int *const glbTextureSize (GLBTexture *texture)
 {
     return texture->dim;
 }
+
+/**
+ * sets an option of the texture.
+ * @param option the option to set, from enum GLBTextureOptions
+ * @param value the new value, as described by the option
+ * @returns 0 on success, or GLB_INVALID_ARGUMENT if the option is not recognized.
+ */
+int glbTextureOption (GLBTexture *texture, int option, int value)
+{
+    if(!texture) GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+
+    switch(option)
+    {
+        case GLB_NO_TEXTURE_OPTIONS:
+            return 0;
+        case GLB_TEXTURE_FENCE_WRITES:
+            texture->fencewrites = value ? true : false;
+            return 0;
+        default:
+            GLB_RETURN_ERROR(GLB_INVALID_ARGUMENT);
+    }
+}
+
+/**
+ * gets the fence inserted after the texture's last write, if writes are fenced
+ * with GLB_TEXTURE_FENCE_WRITES. Once it is signalled the memory the write read
+ * from, such as a pixel unpack buffer, can be reused. The fence belongs to the
+ * texture and is replaced by the next write; retain it to keep it.
+ * @returns the fence, or NULL if no write has been fenced
+ */
+GLBFence *glbTextureFence (GLBTexture *texture)
+{
+    return texture ? texture->fence : NULL;
+}
@@ -39,6 +39,15 @@ enum GLBTextureFlags
     GLB_TEXTURE_ARRAY = 4,  
 };
 
+/**
+ * options set with glbTextureOption.
+ */
+enum GLBTextureOptions
+{
+    GLB_NO_TEXTURE_OPTIONS   = 0,
+    GLB_TEXTURE_FENCE_WRITES = 1, ///< boolean, fence each write, see glbTextureFence
+};
+
 GLBTexture*  glbCreateTexture  (int flags,
                                 enum GLBImageFormat format,
                                 int x,
@@ -77,5 +86,7 @@ int          glbCopyTexture    (GLBTexture *src, GLBTexture *dst,
                                 
 
 const int *const glbTextureSize (GLBTexture *texture);
+int          glbTextureOption  (GLBTexture *texture, int option, int value);
+GLBFence    *glbTextureFence   (GLBTexture *texture);
 
 #endif